@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sim.h"
+#include "src/simulator.h"
+#include "src/out_of_order_scheduler.h"
+#include "src/trace_reader.h"
+#include "src/binary_trace.h"
+#include "src/timing_writer.h"
+
+// Benchmark harness for the simulator itself.
+//
+// Microbenchmarks time the core structures in isolation. End-to-end runs
+// simulate the validation traces over a fixed matrix of configurations,
+// each in a forked child so its peak RSS can be measured. Results are
+// written as "benchmark,metric,value" CSV rows. With --baseline, every
+// *_per_sec metric is compared against the stored value and the harness
+// exits with failure if one dropped by more than the tolerance.
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct BenchmarkResult
+{
+    string Name;
+    string Metric;
+    double Value;
+};
+
+static volatile uint64_t benchmarkSink;
+
+static double SecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Repeats the batch until minimumSeconds have passed and returns the
+// best operations per second of any single batch.
+static double MeasureOperationsPerSecond(const function<uint64_t()> &batch, double minimumSeconds)
+{
+    double bestRate = 0;
+    Clock::time_point start = Clock::now();
+    do
+    {
+        Clock::time_point batchStart = Clock::now();
+        uint64_t operations = batch();
+        double rate = operations / SecondsSince(batchStart);
+        bestRate = rate > bestRate ? rate : bestRate;
+    } while (SecondsSince(start) < minimumSeconds);
+    return bestRate;
+}
+
+// Models the retire scan of a WIDTH 8 machine with a 512 entry window:
+// every step tests the ROB head in the written-back scoreboard and counts
+// the ready bundle behind it, as RetireInstructions does.
+static double BenchmarkRetireScan()
+{
+    const unsigned long robSize = 512;
+    const unsigned long width = 8;
+    Scoreboard writtenBack(robSize);
+    for (unsigned long i = 0; i < robSize; i++)
+    {
+        if ((i * 2654435761u) % 7 != 0)
+        {
+            writtenBack.Set(i);
+        }
+    }
+    unsigned long head = 0;
+    return MeasureOperationsPerSecond([&]()
+    {
+        const uint64_t steps = 1 << 22;
+        uint64_t retired = 0;
+        for (uint64_t step = 0; step < steps; step++)
+        {
+            unsigned long ready = writtenBack.Test(head) ? writtenBack.CountReadyFrom(head, width) : 0;
+            retired += ready;
+            head = (head + max(ready, 1ul)) % robSize;
+        }
+        benchmarkSink = retired;
+        return steps;
+    }, 0.5);
+}
+
+static double BenchmarkRenameMapTableLookup()
+{
+    RenameMapTable renameMapTable;
+    for (int i = 0; i < 67; i += 2)
+    {
+        renameMapTable.AddElement(i * 3, i);
+    }
+    return MeasureOperationsPerSecond([&]()
+    {
+        const uint64_t lookups = 1 << 20;
+        uint64_t hits = 0;
+        RenameMapElement element;
+        for (uint64_t i = 0; i < lookups; i++)
+        {
+            hits += renameMapTable.TryGetElement((i * 2654435761u) % 67, element);
+        }
+        benchmarkSink = hits;
+        return lookups;
+    }, 0.5);
+}
+
+// Models the issue-queue traffic of a WIDTH 8 machine with a 512 entry
+// window: every step renames, dispatches, wakes up and selects 8 instructions.
+static double BenchmarkIssueQueueWakeupSelect()
+{
+    const int robSize = 512;
+    const int width = 8;
+    WakeupTable wakeupTable(robSize);
+    IssueSelector<> issueSelector(robSize);
+    vector<int> selected;
+    int head = 0;
+    int tail = 0;
+    return MeasureOperationsPerSecond([&]()
+    {
+        const uint64_t steps = 1 << 16;
+        for (uint64_t step = 0; step < steps; step++)
+        {
+            for (int i = 0; i < width; i++)
+            {
+                int robValue = tail;
+                tail = (tail + 1) % robSize;
+                Register source1 = {(robValue + robSize - 1 - i) % robSize, true, true};
+                Register source2 = {(robValue + robSize - 5) % robSize, (i & 1) != 0, true};
+                wakeupTable.AllocateEntry(robValue);
+                wakeupTable.AddSourceOperand(robValue, 0, source1);
+                wakeupTable.AddSourceOperand(robValue, 1, source2);
+                issueSelector.Insert(robValue, robValue, wakeupTable.IsInstructionReady(robValue));
+            }
+            issueSelector.SelectOldest(head, width, selected);
+            for (int robValue : selected)
+            {
+                issueSelector.Remove(robValue);
+                wakeupTable.Wakeup(robValue, [&](int consumer) { issueSelector.MarkReady(consumer); });
+            }
+            // Keep the window from overflowing by retiring the oldest entries.
+            for (int i = 0; i < width; i++)
+            {
+                issueSelector.Remove(head);
+                wakeupTable.Wakeup(head, [&](int consumer) { issueSelector.MarkReady(consumer); });
+                head = (head + 1) % robSize;
+            }
+        }
+        benchmarkSink = selected.size();
+        return steps * width;
+    }, 0.5);
+}
+
+static double BenchmarkTraceParsing(const char *fileName)
+{
+    return MeasureOperationsPerSecond([&]()
+    {
+        uint64_t records = 0;
+        for (int repeat = 0; repeat < 20; repeat++)
+        {
+            TraceReader traceReader;
+            TraceRecord record;
+            if (!traceReader.Open(fileName))
+            {
+                fprintf(stderr, "Error: Unable to open %s\n", fileName);
+                exit(EXIT_FAILURE);
+            }
+            while (traceReader.TryGetNext(record))
+            {
+                records++;
+            }
+        }
+        return records;
+    }, 0.5);
+}
+
+// Simulates the trace in a child process and returns its simulated
+// instructions per second and peak resident set size. The run goes through
+// Simulator like ./sim, so specialized configurations use their specialized
+// scheduler.
+static bool RunEndToEnd(const char *traceFile, const SimulatorConfig &config,
+                        double &instructionsPerSecond, long &peakRssKilobytes)
+{
+    int resultPipe[2];
+    if (pipe(resultPipe) != 0)
+    {
+        return false;
+    }
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(resultPipe[0]);
+        FILE *nullOutput = fopen("/dev/null", "w");
+        double rate = MeasureOperationsPerSecond([&]()
+        {
+            Simulator simulator(config);
+            TimingWriter timingWriter(nullOutput);
+            simulator.OpenTrace(traceFile);
+            simulator.AddRetireObserver(&timingWriter);
+            simulator.Run();
+            timingWriter.Flush();
+            return simulator.GetStats().Instructions;
+        }, 1.0);
+        ssize_t written = write(resultPipe[1], &rate, sizeof(rate));
+        _exit(written == sizeof(rate) ? 0 : 1);
+    }
+    close(resultPipe[1]);
+    ssize_t bytesRead = read(resultPipe[0], &instructionsPerSecond, sizeof(instructionsPerSecond));
+    close(resultPipe[0]);
+
+    int status;
+    struct rusage usage;
+    if (child < 0 || wait4(child, &status, 0, &usage) != child)
+    {
+        return false;
+    }
+    peakRssKilobytes = usage.ru_maxrss;
+    return bytesRead == sizeof(instructionsPerSecond) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool LoadBaseline(const char *fileName, map<string, double> &baseline)
+{
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char *firstComma = strchr(line, ',');
+        char *secondComma = firstComma == NULL ? NULL : strchr(firstComma + 1, ',');
+        if (secondComma == NULL)
+        {
+            continue;
+        }
+        *secondComma = '\0';
+        baseline[line] = strtod(secondComma + 1, NULL);
+    }
+    fclose(file);
+    return true;
+}
+
+int main (int argc, char* argv[])
+{
+    const char *outputFile = "bench/results.csv";
+    const char *baselineFile = NULL;
+    const char *traceDirectory = "benchmark_traces";
+    double tolerance = 0.10;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baselineFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            tolerance = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--traces") == 0 && i + 1 < argc)
+        {
+            traceDirectory = argv[++i];
+        }
+        else
+        {
+            printf("Usage: %s [--output results.csv] [--baseline baseline.csv] [--tolerance 0.10] [--traces dir]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const char *traceNames[] = {"val_trace_gcc1", "val_trace_perl1"};
+    const proc_params configurations[] = {
+        {16, 8, 1}, {64, 16, 4}, {128, 32, 4}, {256, 64, 8}, {512, 256, 8}};
+    vector<BenchmarkResult> results;
+
+    string gccTrace = string(traceDirectory) + "/val_trace_gcc1";
+    char binaryTrace[] = "/tmp/oooscheduler_bench_XXXXXX";
+    int binaryDescriptor = mkstemp(binaryTrace);
+    if (binaryDescriptor < 0)
+    {
+        printf("Error: Unable to create a temporary file\n");
+        exit(EXIT_FAILURE);
+    }
+    close(binaryDescriptor);
+    {
+        TraceReader traceReader;
+        BinaryTraceWriter traceWriter;
+        TraceRecord record;
+        if (!traceReader.Open(gccTrace.c_str()) || !traceWriter.Open(binaryTrace))
+        {
+            printf("Error: Unable to convert %s\n", gccTrace.c_str());
+            exit(EXIT_FAILURE);
+        }
+        while (traceReader.TryGetNext(record))
+        {
+            traceWriter.Write(record);
+        }
+    }
+
+    results.push_back({"micro/retire_scan", "scans_per_sec", BenchmarkRetireScan()});
+    results.push_back({"micro/rmt_lookup", "lookups_per_sec", BenchmarkRenameMapTableLookup()});
+    results.push_back({"micro/iq_wakeup_select", "instructions_per_sec", BenchmarkIssueQueueWakeupSelect()});
+    results.push_back({"micro/trace_parse_text", "records_per_sec", BenchmarkTraceParsing(gccTrace.c_str())});
+    results.push_back({"micro/trace_parse_binary", "records_per_sec", BenchmarkTraceParsing(binaryTrace)});
+    unlink(binaryTrace);
+
+    for (const char *traceName : traceNames)
+    {
+        string traceFile = string(traceDirectory) + "/" + traceName;
+        for (const proc_params &params : configurations)
+        {
+            string name = "e2e/" + string(traceName) + "/" + to_string(params.rob_size) + "_"
+                + to_string(params.iq_size) + "_" + to_string(params.width);
+            SimulatorConfig config;
+            config.Params = params;
+            config.OpTypeByLatency = GetDefaultOpTypeLatencies();
+            double instructionsPerSecond;
+            long peakRssKilobytes;
+            if (!RunEndToEnd(traceFile.c_str(), config, instructionsPerSecond, peakRssKilobytes))
+            {
+                printf("Error: End-to-end run %s failed\n", name.c_str());
+                exit(EXIT_FAILURE);
+            }
+            results.push_back({name, "sim_instructions_per_sec", instructionsPerSecond});
+            results.push_back({name, "peak_rss_kb", (double)peakRssKilobytes});
+        }
+    }
+
+    FILE *output = fopen(outputFile, "w");
+    if (output == NULL)
+    {
+        printf("Error: Unable to write %s\n", outputFile);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(output, "benchmark,metric,value\n");
+    for (auto &result : results)
+    {
+        fprintf(output, "%s,%s,%.0f\n", result.Name.c_str(), result.Metric.c_str(), result.Value);
+        printf("%-36s %-26s %14.0f\n", result.Name.c_str(), result.Metric.c_str(), result.Value);
+    }
+    fclose(output);
+
+    if (baselineFile == NULL)
+    {
+        return 0;
+    }
+    map<string, double> baseline;
+    if (!LoadBaseline(baselineFile, baseline))
+    {
+        printf("Error: Unable to read baseline %s\n", baselineFile);
+        exit(EXIT_FAILURE);
+    }
+    int regressions = 0;
+    for (auto &result : results)
+    {
+        string key = result.Name + "," + result.Metric;
+        bool isThroughput = result.Metric.size() > 8
+            && result.Metric.compare(result.Metric.size() - 8, 8, "_per_sec") == 0;
+        if (!isThroughput || baseline.count(key) == 0)
+        {
+            continue;
+        }
+        double floor = baseline[key] * (1 - tolerance);
+        if (result.Value < floor)
+        {
+            printf("REGRESSION %s %s: %.0f < %.0f (baseline %.0f, tolerance %.0f%%)\n",
+                result.Name.c_str(), result.Metric.c_str(), result.Value, floor, baseline[key], tolerance * 100);
+            regressions++;
+        }
+    }
+    printf("%d throughput regression(s) against %s\n", regressions, baselineFile);
+    return regressions == 0 ? 0 : 1;
+}
@@ -3,90 +3,339 @@
 #include <string.h>
 #include <map>
 #include <inttypes.h>
-#include <algorithm>
 #include "sim.h"
-#include "src/out_of_order_scheduler.h"
+#include "src/simulator.h"
+#include "src/timing_writer.h"
+#include "src/pipeline_view_writer.h"
+#include "src/timing_log.h"
+#include "src/trace_reader.h"
+#include "src/decode_thread.h"
+#include "src/design_sweep.h"
+#include "src/batch_runner.h"
+#include "src/sampled_simulation.h"
+#include "src/checkpoint.h"
+
+// Sweep mode: ./sim --sweep <configurations> <tracefile> [threads]
+// Decodes the trace once and simulates every configuration on a pool of
+// threads, printing one CSV row per configuration.
+int RunSweepMode(int argc, char* argv[], const std::map<int, int> &opTypeByLatency)
+{
+    vector<proc_params> configurations;
+    vector<TraceRecord> records;
+    vector<SweepResult> results;
+
+    if (argc != 4 && argc != 5)
+    {
+        printf("Usage: %s --sweep <ROB_LIST:IQ_LIST:WIDTH_LIST | config file> <tracefile> [threads]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (!ParseSweepConfigurations(argv[2], configurations))
+    {
+        printf("Error: Invalid sweep configurations %s\n", argv[2]);
+        exit(EXIT_FAILURE);
+    }
+    if (!ReadWholeTrace(argv[3], records))
+    {
+        printf("Error: Unable to read trace file %s\n", argv[3]);
+        exit(EXIT_FAILURE);
+    }
+    unsigned threadCount = argc == 5 ? strtoul(argv[4], NULL, 10) : WorkStealingPool::GetDefaultThreadCount();
+
+    RunDesignSweep(records, configurations, opTypeByLatency, threadCount, results);
+    PrintSweepResults(stdout, configurations, results);
+    return 0;
+}
+
+// Batch mode: ./sim --batch <manifest> [threads] [csv|json]
+// Simulates every (trace, ROB_SIZE, IQ_SIZE, WIDTH) job of the manifest on
+// a pool of threads and prints one result per job.
+int RunBatchMode(int argc, char* argv[], const std::map<int, int> &opTypeByLatency)
+{
+    vector<BatchJob> jobs;
+    vector<BatchResult> results;
+    string error;
+
+    bool json = argc > 3 && strcmp(argv[argc - 1], "json") == 0;
+    bool hasFormat = argc > 3 && (json || strcmp(argv[argc - 1], "csv") == 0);
+    int threadArguments = argc - 3 - (hasFormat ? 1 : 0);
+    if (argc < 3 || threadArguments > 1)
+    {
+        printf("Usage: %s --batch <manifest> [threads] [csv|json]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (!ParseBatchManifest(argv[2], jobs, error))
+    {
+        printf("Error: Invalid batch manifest %s: %s\n", argv[2], error.c_str());
+        exit(EXIT_FAILURE);
+    }
+    unsigned threadCount = threadArguments == 1 ? strtoul(argv[3], NULL, 10) : WorkStealingPool::GetDefaultThreadCount();
+
+    RunBatch(jobs, opTypeByLatency, threadCount, results);
+    PrintBatchResults(stdout, jobs, results, json);
+    return 0;
+}
+
+// Sampled mode: ./sim --sample <UNIT:WARMUP:PERIOD> <ROB_SIZE> <IQ_SIZE> <WIDTH> <tracefile>
+// Simulates WARMUP + UNIT instructions in detail out of every PERIOD and
+// reports the estimated IPC with a 95% confidence interval.
+int RunSampledMode(const char *program,
+                   const proc_params &params,
+                   const char *traceFile,
+                   const char *samplingSpecification,
+                   TraceSource *traceSource,
+                   const std::map<int, int> &opTypeByLatency,
+                   unsigned long architecturalRegisterCount)
+{
+    SamplingParameters samplingParameters;
+    SamplingResult samplingResult;
+    if (!ParseSamplingParameters(samplingSpecification, samplingParameters))
+    {
+        printf("Error: Invalid sampling parameters %s (expected UNIT:WARMUP:PERIOD)\n", samplingSpecification);
+        exit(EXIT_FAILURE);
+    }
+
+    RunSampledSimulation(traceSource, params, opTypeByLatency, samplingParameters, samplingResult,
+                         architecturalRegisterCount);
+
+    printf("# === Simulator Command =========\n");
+    printf("# %s --sample %s %lu %lu %lu %s\n", program, samplingSpecification,
+            params.rob_size, params.iq_size, params.width, traceFile);
+    printf("# === Processor Configuration ===\n");
+    printf("# ROB_SIZE = %lu\n", params.rob_size);
+    printf("# IQ_SIZE = %lu\n", params.iq_size);
+    printf("# WIDTH = %lu\n", params.width);
+    printf("# === Sampled Simulation Results\n");
+    PrintSamplingResults(stdout, samplingParameters, samplingResult);
+    return 0;
+}
 
 int main (int argc, char* argv[])
 {
-    FILE *FP;               // File handler
+    TraceReader traceReader;  // Decodes the trace file ahead of fetch
+    DecodeThread decodeThread;      // Runs traceReader on its own thread
+    TraceSource *traceSource = &traceReader;
+    unsigned long decodeDepth = 0;          // Ring depth; 0 decodes on the simulation thread
     char *trace_file;       // Variable that holds trace file name;
     proc_params params;       // look at sim_bp.h header file for the the definition of struct proc_params
-    int op_type, dest, src1, src2;  // Variables are read from trace file
-    uint64_t pc; // Variable holds the pc read from input file
-    
+    vector<char*> positionalArgs;   // ROB_SIZE, IQ_SIZE, WIDTH and tracefile
+    const char *samplingSpecification = NULL;
+    const char *checkpointFile = NULL;      // Where checkpoints are written
+    const char *checkpointSpecification = NULL;
+    const char *restoreFile = NULL;         // Checkpoint to resume from
+    CheckpointSchedule checkpointSchedule;
+    bool printStatistics = false;           // Stall counters and CPI stack after the summary
+    bool printProfile = false;              // Per-stage time after the summary
+    const char *pipelineViewFile = NULL;    // Chrome trace-event export
+    const char *pipelineViewRange = NULL;   // FIRST:LAST sequence numbers to export
+    const char *timingLogFile = NULL;       // Columnar binary timings instead of text lines
+    unsigned long architecturalRegisterCount = DefaultArchitecturalRegisterCount;
     
-    std::map<int, int> opTypeByLatency;
-    opTypeByLatency[0] = 1;
-    opTypeByLatency[1] = 2;
-    opTypeByLatency[2] = 5;
-    if (argc != 5)
+    std::map<int, int> opTypeByLatency = GetDefaultOpTypeLatencies();
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0)
+    {
+        return RunSweepMode(argc, argv, opTypeByLatency);
+    }
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0)
+    {
+        return RunBatchMode(argc, argv, opTypeByLatency);
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc)
+        {
+            samplingSpecification = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            checkpointFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-at") == 0 && i + 1 < argc)
+        {
+            checkpointSpecification = argv[++i];
+        }
+        else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc)
+        {
+            restoreFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pipeline-view") == 0 && i + 1 < argc)
+        {
+            pipelineViewFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pipeline-view-range") == 0 && i + 1 < argc)
+        {
+            pipelineViewRange = argv[++i];
+        }
+        else if (strcmp(argv[i], "--timing-log") == 0 && i + 1 < argc)
+        {
+            timingLogFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--arch-registers") == 0 && i + 1 < argc)
+        {
+            architecturalRegisterCount = strtoul(argv[++i], NULL, 10);
+            if (architecturalRegisterCount == 0)
+            {
+                printf("Error: Invalid architectural register count %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--decode-thread") == 0 && i + 1 < argc)
+        {
+            decodeDepth = strtoul(argv[++i], NULL, 10);
+            if (decodeDepth == 0)
+            {
+                printf("Error: Invalid decode ring depth %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            printStatistics = true;
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            if (!StageProfiler::Enabled)
+            {
+                printf("Error: --profile needs a build with the stage profiler (make clean && make PROFILE=1)\n");
+                exit(EXIT_FAILURE);
+            }
+            printProfile = true;
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            printf("Error: Unknown option %s\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+        else
+        {
+            positionalArgs.push_back(argv[i]);
+        }
+    }
+    if (positionalArgs.size() != 4)
     {
         printf("Error: Wrong number of inputs:%d\n", argc-1);
         exit(EXIT_FAILURE);
     }
     
-    params.rob_size     = strtoul(argv[1], NULL, 10);
-    params.iq_size      = strtoul(argv[2], NULL, 10);
-    params.width        = strtoul(argv[3], NULL, 10);
-    trace_file          = argv[4];
+    params.rob_size     = strtoul(positionalArgs[0], NULL, 10);
+    params.iq_size      = strtoul(positionalArgs[1], NULL, 10);
+    params.width        = strtoul(positionalArgs[2], NULL, 10);
+    trace_file          = positionalArgs[3];
+    if ((checkpointFile == NULL) != (checkpointSpecification == NULL)
+        || (checkpointSpecification != NULL && !checkpointSchedule.Parse(checkpointSpecification)))
+    {
+        printf("Error: --checkpoint <file> needs --checkpoint-at <cycle:N | instruction:N | every:N>\n");
+        exit(EXIT_FAILURE);
+    }
     // Open trace_file in read mode
-    FP = fopen(trace_file, "r");
-    if(FP == NULL)
+    if(!traceReader.Open(trace_file))
     {
         // Throw error and exit if fopen() failed
         printf("Error: Unable to open file %s\n", trace_file);
         exit(EXIT_FAILURE);
     }
-    unsigned long currentCycleCount = 0;
-    unsigned long fetchedInstructions = 0;
-    Scheduler outOfOrderScheduler = Scheduler(FP, params.width, params.rob_size, params.iq_size, currentCycleCount);
+    if (decodeDepth != 0)
+    {
+        decodeThread.Start(&traceReader, decodeDepth);
+        traceSource = &decodeThread;
+    }
+    if (samplingSpecification != NULL)
+    {
+        return RunSampledMode(argv[0], params, trace_file, samplingSpecification, traceSource, opTypeByLatency,
+                              architecturalRegisterCount);
+    }
+
+    // Instructions retire in program order, so their timing lines are
+    // streamed out as they retire instead of being kept until the end.
+    TimingWriter timingWriter = TimingWriter(stdout);
+    TimingLogWriter timingLogWriter;
+    PipelineViewWriter pipelineViewWriter;
+    SimulatorConfig config;
+    config.Params = params;
+    config.OpTypeByLatency = opTypeByLatency;
+    config.ArchitecturalRegisterCount = architecturalRegisterCount;
+    Simulator simulator(config);
+    simulator.SetTrace(traceSource);
+    if (timingLogFile == NULL)
+    {
+        simulator.AddRetireObserver(&timingWriter);
+    }
+    else
+    {
+        if (!timingLogWriter.Open(timingLogFile))
+        {
+            printf("Error: Unable to create %s\n", timingLogFile);
+            exit(EXIT_FAILURE);
+        }
+        simulator.AddRetireObserver(&timingLogWriter);
+    }
+    if (pipelineViewFile != NULL)
+    {
+        uint64_t firstSequenceNumber = 0;
+        uint64_t lastSequenceNumber = std::numeric_limits<uint64_t>::max();
+        if (pipelineViewRange != NULL
+            && !ParseSequenceRange(pipelineViewRange, firstSequenceNumber, lastSequenceNumber))
+        {
+            printf("Error: Invalid pipeline view range %s (expected FIRST:LAST)\n", pipelineViewRange);
+            exit(EXIT_FAILURE);
+        }
+        if (!pipelineViewWriter.Open(pipelineViewFile, firstSequenceNumber, lastSequenceNumber))
+        {
+            printf("Error: Unable to create %s\n", pipelineViewFile);
+            exit(EXIT_FAILURE);
+        }
+        simulator.AddRetireObserver(&pipelineViewWriter);
+    }
+    if (restoreFile != NULL)
+    {
+        string error;
+        if (!simulator.RestoreCheckpoint(restoreFile, error))
+        {
+            printf("Error: Unable to restore %s: %s\n", restoreFile, error.c_str());
+            exit(EXIT_FAILURE);
+        }
+        // An interrupted run may have printed instructions retired after
+        // the checkpoint; only its first this-many timing lines belong
+        // before the resumed output.
+        fprintf(stderr, "Resuming at cycle %" PRIu64 " after %" PRIu64 " retired instructions\n",
+                simulator.GetCycles(), simulator.GetRetiredInstructions());
+    }
+
+    bool running;
     do
     {
-        outOfOrderScheduler.RetireInstructions();
-        outOfOrderScheduler.WritebackToRegister();
-        outOfOrderScheduler.Execute();
-        outOfOrderScheduler.IssueInstruction(opTypeByLatency);
-        outOfOrderScheduler.DispatchInstruction();
-        outOfOrderScheduler.ReadRegister();
-        outOfOrderScheduler.Rename();
-        outOfOrderScheduler.DecodeInstruction();
-        outOfOrderScheduler.FetchInstruction(fetchedInstructions);
-        currentCycleCount++;
-    } while (outOfOrderScheduler.AdvanceToNextCycle());
+        running = simulator.Step();
+        if (checkpointSchedule.IsDue(simulator.GetCycles(), simulator.GetRetiredInstructions()))
+        {
+            // Everything retired before the checkpoint is written out first,
+            // so a resumed run can append to the same output.
+            timingWriter.Flush();
+            timingLogWriter.Flush();
+            pipelineViewWriter.Flush();
+            fflush(stdout);
+            if (!simulator.SaveCheckpoint(checkpointFile))
+            {
+                fprintf(stderr, "Warning: Unable to write checkpoint %s\n", checkpointFile);
+            }
+        }
+    } while (running);
 
-    sort(outOfOrderScheduler.FinalInstructions.begin(), outOfOrderScheduler.FinalInstructions.end(), [](const Instruction& a, const Instruction& b) {
-        return a.InstructionSequenceNumber < b.InstructionSequenceNumber;
-    });
-    
-    // Print the final instructions cycle sequentially.
-    for (auto& instruction : outOfOrderScheduler.FinalInstructions) 
-    {
-        printf("%d fu{%d} src{%d,%d} dst{%d} FE{%d,%d} DE{%d,%d} RN{%d,%d} RR{%d,%d} DI{%d,%d} IS{%d,%d} EX{%d,%d} WB{%d,%d} RT{%d,%d}\n", 
-            instruction.InstructionSequenceNumber, 
-            instruction.OpType, 
-            instruction.SourceRegister1.Value,
-            instruction.SourceRegister2.Value,
-            instruction.DestinationRegister.Value,
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::FE),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::FE),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::DE),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::DE),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::RN),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::RN),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::RR),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::RR),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::DI),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::DI),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::IS),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::IS),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::EX),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::EX),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::WB),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::WB),
-            instruction.GetBeginCycleValueForRegister(PipelineRegister::RT),
-            instruction.GetEndCycleValueForRegister(PipelineRegister::RT)
-            );
+    if (simulator.HasOutOfRangeRegister())
+    {
+        fprintf(stderr, "Warning: the trace writes registers beyond the %lu architectural registers; "
+                "use --arch-registers to rename them\n", architecturalRegisterCount);
+    }
+    timingWriter.Flush();
+    if (!timingLogWriter.Close())
+    {
+        fprintf(stderr, "Warning: Unable to write timing log %s\n", timingLogFile);
+    }
+    if (!pipelineViewWriter.Close())
+    {
+        fprintf(stderr, "Warning: Unable to write pipeline view %s\n", pipelineViewFile);
+    }
+    if (traceReader.HasMalformedLine())
+    {
+        fprintf(stderr, "Warning: Stopped reading %s at a malformed line\n", trace_file);
     }
 
     printf("# === Simulator Command =========\n");
@@ -99,9 +348,18 @@ int main (int argc, char* argv[])
     printf("# ROB_SIZE = %lu\n", params.rob_size);
     printf("# IQ_SIZE = %lu\n", params.iq_size);
     printf("# WIDTH = %lu\n", params.width);
+    SimulatorStats result = simulator.GetStats();
     printf("# === Simulation Results ========\n");
-    printf("# Dynamic Instruction Count    = %lu\n", fetchedInstructions);
-    printf("# Cycles                       = %lu\n", currentCycleCount);
-    printf("# Instructions Per Cycle (IPC) = %1.2f\n", (float)fetchedInstructions/currentCycleCount);
+    printf("# Dynamic Instruction Count    = %" PRIu64 "\n", result.Instructions);
+    printf("# Cycles                       = %" PRIu64 "\n", result.Cycles);
+    printf("# Instructions Per Cycle (IPC) = %1.2f\n", (float)result.Instructions/result.Cycles);
+    if (printStatistics)
+    {
+        result.Statistics.Print(stdout, result.RetiredInstructions, params.width);
+    }
+    if (printProfile)
+    {
+        simulator.PrintProfile(stdout);
+    }
     return 0;
 }
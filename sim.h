@@ -1,6 +1,8 @@
 #ifndef SIM_H
 #define SIM_H
 
+#include <inttypes.h>
+
 typedef struct proc_params{
     unsigned long int rob_size;
     unsigned long int iq_size;
@@ -16,12 +18,15 @@ enum PipelineRegister {
     IS,
     EX,
     WB,
-    RT
+    RT,
+    TotalPipelineRegisters
 };
 
+// Start is stored relative to the fetch cycle of the instruction, so both
+// fields stay 32 bits wide while absolute cycle counts are 64 bits.
 struct CycleInfo {
-    int start;
-    int finish;
+    int32_t start;
+    int32_t finish;
 };
 
 struct RenameMapElement
@@ -31,4 +36,19 @@ struct RenameMapElement
     bool Valid;
 };
 
+struct TraceRecord
+{
+    uint64_t ProgramCounter;
+    int OpType;
+    int DestinationRegister;
+    int SourceRegister1;
+    int SourceRegister2;
+};
+
+struct WakeupDependent
+{
+    int RobValue;
+    int Operand;
+};
+
 #endif
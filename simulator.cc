@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include "sim.h"
+#include "src/simulator.h"
+#include "src/out_of_order_scheduler.h"
+#include "src/trace_reader.h"
+#include "src/checkpoint.h"
+
+// The scheduler behind a Simulator. Each configuration gets its own
+// SchedulerCore instantiation, so the type is hidden behind this interface.
+class SimulationEngine
+{
+    public:
+        virtual ~SimulationEngine() {}
+        virtual bool Step() = 0;
+        virtual void Run() = 0;
+        virtual void SetRetireObservers(const vector<RetireObserver*> &observers) = 0;
+        virtual uint64_t GetCycles() = 0;
+        virtual uint64_t GetRetiredInstructions() = 0;
+        virtual void GetStats(SimulatorStats &stats) = 0;
+        virtual void PrintProfile(FILE *output) = 0;
+        virtual bool HasOutOfRangeRegister() = 0;
+        virtual bool SaveCheckpoint(const char *fileName, const proc_params &params) = 0;
+        virtual bool RestoreCheckpoint(const char *fileName, const proc_params &params, string &error) = 0;
+};
+
+// Runs a configuration on SchedulerCore<Width, RobSize, IqSize>.
+template <unsigned long Width, unsigned long RobSize, unsigned long IqSize>
+class SchedulerEngine final : public SimulationEngine
+{
+    public:
+        SchedulerEngine(TraceSource *source, const SimulatorConfig &config)
+            : scheduler(source, config.Params.width, config.Params.rob_size, config.Params.iq_size,
+                        config.OpTypeByLatency, config.ArchitecturalRegisterCount)
+        {
+            traceSource = source;
+        }
+
+        bool Step() override
+        {
+            scheduler.RunCycle();
+            scheduler.FastForwardIdleCycles();
+            return scheduler.AdvanceToNextCycle();
+        }
+
+        void Run() override
+        {
+            while (Step())
+            {
+            }
+        }
+
+        void SetRetireObservers(const vector<RetireObserver*> &observers) override
+        {
+            scheduler.RetireObservers = observers;
+        }
+
+        uint64_t GetCycles() override
+        {
+            return scheduler.CurrentCyclesCount;
+        }
+
+        uint64_t GetRetiredInstructions() override
+        {
+            return scheduler.RetiredInstructionsCount;
+        }
+
+        void GetStats(SimulatorStats &stats) override
+        {
+            stats.Instructions = scheduler.FetchedInstructionsCount;
+            stats.Cycles = scheduler.CurrentCyclesCount;
+            stats.RetiredInstructions = scheduler.RetiredInstructionsCount;
+            stats.Statistics = scheduler.Statistics;
+        }
+
+        void PrintProfile(FILE *output) override
+        {
+            scheduler.Profiler.Print(output, scheduler.CurrentCyclesCount, scheduler.FetchedInstructionsCount);
+        }
+
+        bool HasOutOfRangeRegister() override
+        {
+            return scheduler.RMT.HasOutOfRangeRegister();
+        }
+
+        bool SaveCheckpoint(const char *fileName, const proc_params &params) override
+        {
+            return ::SaveCheckpoint(fileName, scheduler, params, traceSource);
+        }
+
+        bool RestoreCheckpoint(const char *fileName, const proc_params &params, string &error) override
+        {
+            return ::RestoreCheckpoint(fileName, scheduler, params, traceSource, error);
+        }
+
+    private:
+        SchedulerCore<Width, RobSize, IqSize> scheduler;
+        TraceSource *traceSource;
+};
+
+// A configuration with a scheduler instantiated for its exact sizes.
+struct SpecializedScheduler
+{
+    unsigned long RobSize;
+    unsigned long IqSize;
+    unsigned long Width;
+    SimulationEngine *(*Create)(TraceSource *source, const SimulatorConfig &config);
+};
+
+template <unsigned long Width, unsigned long RobSize, unsigned long IqSize>
+SimulationEngine *CreateSchedulerEngine(TraceSource *source, const SimulatorConfig &config)
+{
+    return new SchedulerEngine<Width, RobSize, IqSize>(source, config);
+}
+
+// The configurations swept most often: WIDTH 1/2/4/8 with power-of-two
+// windows. Each entry costs compile time, so only add hot ones.
+const SpecializedScheduler SpecializedSchedulers[] = {
+    {16, 8, 1, CreateSchedulerEngine<1, 16, 8>},
+    {32, 16, 1, CreateSchedulerEngine<1, 32, 16>},
+    {32, 8, 2, CreateSchedulerEngine<2, 32, 8>},
+    {64, 32, 2, CreateSchedulerEngine<2, 64, 32>},
+    {64, 16, 4, CreateSchedulerEngine<4, 64, 16>},
+    {128, 32, 4, CreateSchedulerEngine<4, 128, 32>},
+    {256, 64, 4, CreateSchedulerEngine<4, 256, 64>},
+    {256, 64, 8, CreateSchedulerEngine<8, 256, 64>},
+    {512, 128, 8, CreateSchedulerEngine<8, 512, 128>},
+    {512, 256, 8, CreateSchedulerEngine<8, 512, 256>},
+};
+
+// Forwards retired instructions to a std::function.
+class CallbackRetireObserver : public RetireObserver
+{
+    public:
+        CallbackRetireObserver(function<void(const Instruction&)> callback) : onRetire(callback)
+        {
+        }
+
+        void OnRetire(const Instruction &instruction) override
+        {
+            onRetire(instruction);
+        }
+
+    private:
+        function<void(const Instruction&)> onRetire;
+};
+
+Simulator::Simulator(const SimulatorConfig &simulatorConfig) : config(simulatorConfig)
+{
+}
+
+Simulator::~Simulator()
+{
+}
+
+void Simulator::SetTrace(TraceSource *source)
+{
+    CreateEngine(source);
+}
+
+void Simulator::SetTrace(const TraceRecord *records, size_t count)
+{
+    memoryTrace.reset(new MemoryTraceSource(records, count));
+    CreateEngine(memoryTrace.get());
+}
+
+bool Simulator::OpenTrace(const char *fileName)
+{
+    traceReader.reset(new TraceReader());
+    if (!traceReader->Open(fileName))
+    {
+        traceReader.reset();
+        return false;
+    }
+    CreateEngine(traceReader.get());
+    return true;
+}
+
+bool Simulator::HasMalformedTrace()
+{
+    return traceReader != NULL && traceReader->HasMalformedLine();
+}
+
+void Simulator::AddRetireObserver(RetireObserver *observer)
+{
+    retireObservers.push_back(observer);
+    if (engine != NULL)
+    {
+        engine->SetRetireObservers(retireObservers);
+    }
+}
+
+void Simulator::SetRetireCallback(function<void(const Instruction&)> callback)
+{
+    retireCallback.reset(new CallbackRetireObserver(callback));
+    AddRetireObserver(retireCallback.get());
+}
+
+bool Simulator::Step()
+{
+    return engine != NULL && engine->Step();
+}
+
+void Simulator::Run()
+{
+    if (engine != NULL)
+    {
+        engine->Run();
+    }
+}
+
+uint64_t Simulator::GetCycles()
+{
+    return engine == NULL ? 0 : engine->GetCycles();
+}
+
+uint64_t Simulator::GetRetiredInstructions()
+{
+    return engine == NULL ? 0 : engine->GetRetiredInstructions();
+}
+
+SimulatorStats Simulator::GetStats()
+{
+    SimulatorStats stats;
+    if (engine != NULL)
+    {
+        engine->GetStats(stats);
+    }
+    return stats;
+}
+
+void Simulator::PrintProfile(FILE *output)
+{
+    if (engine != NULL)
+    {
+        engine->PrintProfile(output);
+    }
+}
+
+bool Simulator::HasOutOfRangeRegister()
+{
+    return engine != NULL && engine->HasOutOfRangeRegister();
+}
+
+bool Simulator::SaveCheckpoint(const char *fileName)
+{
+    return engine != NULL && engine->SaveCheckpoint(fileName, config.Params);
+}
+
+bool Simulator::RestoreCheckpoint(const char *fileName, string &error)
+{
+    if (engine == NULL)
+    {
+        error = "no trace was set";
+        return false;
+    }
+    return engine->RestoreCheckpoint(fileName, config.Params, error);
+}
+
+// Runs the configuration on its specialized scheduler if there is one and
+// on the generic scheduler otherwise. Both produce identical results.
+void Simulator::CreateEngine(TraceSource *source)
+{
+    engine.reset();
+    for (const SpecializedScheduler &specialized : SpecializedSchedulers)
+    {
+        if (specialized.RobSize == config.Params.rob_size
+            && specialized.IqSize == config.Params.iq_size
+            && specialized.Width == config.Params.width)
+        {
+            engine.reset(specialized.Create(source, config));
+            break;
+        }
+    }
+    if (engine == NULL)
+    {
+        engine.reset(new SchedulerEngine<0, 0, 0>(source, config));
+    }
+    engine->SetRetireObservers(retireObservers);
+}
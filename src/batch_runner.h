@@ -0,0 +1,192 @@
+#ifndef BATCH_RUNNER_H   // Include guard to prevent multiple inclusions
+#define BATCH_RUNNER_H
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "sim.h"
+#include "simulator.h"
+#include "design_sweep.h"
+#include "work_stealing_pool.h"
+
+using namespace std;
+
+/// @brief One (trace, configuration) pair of a batch manifest.
+struct BatchJob
+{
+    string TraceFile;
+    proc_params Params;
+    uint64_t TraceBytes = 0;
+};
+
+/// @brief Outcome of one batch job.
+struct BatchResult
+{
+    bool Completed = false;
+    uint64_t Instructions = 0;
+    uint64_t Cycles = 0;
+    double WallSeconds = 0;
+};
+
+/// @brief Reads a batch manifest with one "TRACE ROB_SIZE IQ_SIZE WIDTH"
+/// job per line ('#' starts a comment). Trace paths cannot contain spaces.
+/// @param fileName Path of the manifest.
+/// @param jobs [out] Jobs in manifest order.
+/// @param error [out] Reason for a failure.
+inline bool ParseBatchManifest(const char *fileName, vector<BatchJob> &jobs, string &error)
+{
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL)
+    {
+        error = "unable to open the manifest";
+        return false;
+    }
+    char line[4096];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+        {
+            *comment = '\0';
+        }
+        char traceFile[4096];
+        BatchJob job;
+        char extra;
+        int fields = sscanf(line, "%4095s %lu %lu %lu %c", traceFile,
+                            &job.Params.rob_size, &job.Params.iq_size, &job.Params.width, &extra);
+        if (fields == EOF)
+        {
+            continue;
+        }
+        struct stat traceStatus;
+        if (fields != 4 || !IsConfigurationSimulatable(job.Params))
+        {
+            error = "line " + to_string(lineNumber) + " is not a TRACE ROB_SIZE IQ_SIZE WIDTH job";
+        }
+        else if (stat(traceFile, &traceStatus) != 0)
+        {
+            error = "line " + to_string(lineNumber) + ": unable to open " + traceFile;
+        }
+        if (!error.empty())
+        {
+            fclose(file);
+            return false;
+        }
+        job.TraceFile = traceFile;
+        job.TraceBytes = traceStatus.st_size;
+        jobs.push_back(job);
+    }
+    fclose(file);
+    if (jobs.empty())
+    {
+        error = "the manifest has no jobs";
+        return false;
+    }
+    return true;
+}
+
+/// @brief Simulates every job of a batch on a work-stealing pool.
+/// Jobs are handed out longest trace first, so a long trace does not start
+/// last and leave the other workers idle. Each job streams its own trace, so
+/// a worker only holds one trace buffer at a time.
+/// @param jobs Jobs to simulate.
+/// @param opTypeByLatency Execution latency of each op type.
+/// @param threadCount Number of worker threads.
+/// @param results [out] One result per job, in the same order.
+inline void RunBatch(const vector<BatchJob> &jobs,
+                     const map<int, int> &opTypeByLatency,
+                     unsigned threadCount,
+                     vector<BatchResult> &results)
+{
+    results.assign(jobs.size(), BatchResult());
+    vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&jobs](size_t left, size_t right)
+    {
+        return jobs[left].TraceBytes > jobs[right].TraceBytes;
+    });
+
+    WorkStealingPool pool(threadCount);
+    pool.Run(order, [&](size_t job)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        SimulatorConfig config;
+        config.Params = jobs[job].Params;
+        config.OpTypeByLatency = opTypeByLatency;
+        Simulator simulator(config);
+        if (!simulator.OpenTrace(jobs[job].TraceFile.c_str()))
+        {
+            return;
+        }
+        simulator.Run();
+
+        SimulatorStats stats = simulator.GetStats();
+        BatchResult &result = results[job];
+        result.Completed = !simulator.HasMalformedTrace();
+        result.Instructions = stats.Instructions;
+        result.Cycles = stats.Cycles;
+        result.WallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    });
+}
+
+/// @brief Writes one result per job, as CSV or as a JSON array.
+inline void PrintBatchResults(FILE *file, const vector<BatchJob> &jobs, const vector<BatchResult> &results, bool json)
+{
+    if (json)
+    {
+        fprintf(file, "[\n");
+    }
+    else
+    {
+        fprintf(file, "trace,rob_size,iq_size,width,status,instructions,cycles,ipc,wall_seconds,mips\n");
+    }
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        const BatchResult &result = results[i];
+        double ipc = result.Cycles == 0 ? 0.0 : (double)result.Instructions / result.Cycles;
+        double mips = result.WallSeconds == 0 ? 0.0 : result.Instructions / result.WallSeconds / 1e6;
+        const char *status = result.Completed ? "ok" : "failed";
+        if (json)
+        {
+            string trace;
+            for (char c : jobs[i].TraceFile)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    trace += '\\';
+                }
+                trace += c;
+            }
+            fprintf(file, "  {\"trace\": \"%s\", \"rob_size\": %lu, \"iq_size\": %lu, \"width\": %lu, "
+                    "\"status\": \"%s\", \"instructions\": %" PRIu64 ", \"cycles\": %" PRIu64 ", "
+                    "\"ipc\": %.4f, \"wall_seconds\": %.6f, \"mips\": %.3f}%s\n",
+                    trace.c_str(), jobs[i].Params.rob_size, jobs[i].Params.iq_size, jobs[i].Params.width,
+                    status, result.Instructions, result.Cycles, ipc, result.WallSeconds, mips,
+                    i + 1 < jobs.size() ? "," : "");
+        }
+        else
+        {
+            fprintf(file, "%s,%lu,%lu,%lu,%s,%" PRIu64 ",%" PRIu64 ",%.4f,%.6f,%.3f\n",
+                    jobs[i].TraceFile.c_str(), jobs[i].Params.rob_size, jobs[i].Params.iq_size,
+                    jobs[i].Params.width, status, result.Instructions, result.Cycles, ipc,
+                    result.WallSeconds, mips);
+        }
+    }
+    if (json)
+    {
+        fprintf(file, "]\n");
+    }
+}
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef BINARY_TRACE_H   // Include guard to prevent multiple inclusions
+#define BINARY_TRACE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <vector>
+#include "sim.h"
+
+using namespace std;
+
+// Binary trace layout (all integers little endian):
+//
+//   header:  "OOOTRACE" | uint32 version | uint32 reserved | uint64 record count
+//   record:  uint8 control
+//            [zigzag varint PC delta]   unless CONTROL_PC_DELTA_IS_4
+//            3 x uint8 registers        dst, src1, src2; 0xFF encodes -1
+//            or 3 x int32 registers     if CONTROL_WIDE_REGISTERS
+//
+// The low three bits of the control byte hold the op type. Sequential code
+// therefore costs four bytes per instruction.
+const char BinaryTraceMagic[8] = {'O', 'O', 'O', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t BinaryTraceVersion = 1;
+const size_t BinaryTraceHeaderSize = 24;
+const size_t MaxBinaryRecordSize = 1 + 10 + 12;
+
+const uint8_t CONTROL_OP_TYPE_MASK = 0x07;
+const uint8_t CONTROL_PC_DELTA_IS_4 = 0x08;
+const uint8_t CONTROL_WIDE_REGISTERS = 0x10;
+const uint8_t CONTROL_RESERVED_MASK = 0xE0;
+
+/// @brief Checks whether a buffer starts with a binary trace header.
+/// @param data Start of the file contents.
+/// @param size Number of bytes available.
+inline bool IsBinaryTrace(const char *data, size_t size)
+{
+    return size >= BinaryTraceHeaderSize && memcmp(data, BinaryTraceMagic, sizeof(BinaryTraceMagic)) == 0;
+}
+
+inline void StoreLittleEndian(uint8_t *out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+inline uint64_t LoadLittleEndian(const uint8_t *in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+/// @brief Encodes one record.
+/// @param record The record to encode.
+/// @param previousPc PC of the previous record, updated to the PC of this one.
+/// @param out [out] Buffer of at least MaxBinaryRecordSize bytes.
+/// @return Number of bytes written, or 0 if the op type cannot be encoded.
+inline size_t EncodeBinaryRecord(const TraceRecord &record, uint64_t &previousPc, uint8_t *out)
+{
+    if (record.OpType < 0 || record.OpType > CONTROL_OP_TYPE_MASK)
+    {
+        return 0;
+    }
+    uint8_t control = (uint8_t)record.OpType;
+    size_t used = 1;
+
+    uint64_t delta = record.ProgramCounter - previousPc;
+    if (delta == 4)
+    {
+        control |= CONTROL_PC_DELTA_IS_4;
+    }
+    else
+    {
+        int64_t signedDelta = (int64_t)delta;
+        uint64_t zigzag = ((uint64_t)signedDelta << 1) ^ (uint64_t)(signedDelta >> 63);
+        while (zigzag >= 0x80)
+        {
+            out[used++] = (uint8_t)(zigzag | 0x80);
+            zigzag >>= 7;
+        }
+        out[used++] = (uint8_t)zigzag;
+    }
+    previousPc = record.ProgramCounter;
+
+    int registers[3] = {record.DestinationRegister, record.SourceRegister1, record.SourceRegister2};
+    bool narrow = true;
+    for (int value : registers)
+    {
+        narrow = narrow && value >= -1 && value < 0xFF;
+    }
+    for (int value : registers)
+    {
+        if (narrow)
+        {
+            out[used++] = (uint8_t)value;
+        }
+        else
+        {
+            StoreLittleEndian(out + used, (uint32_t)value, 4);
+            used += 4;
+        }
+    }
+    if (!narrow)
+    {
+        control |= CONTROL_WIDE_REGISTERS;
+    }
+    out[0] = control;
+    return used;
+}
+
+/// @brief Decodes one record.
+/// @param cursor Start of the record, advanced past it on success.
+/// @param end End of the available data.
+/// @param previousPc PC of the previous record, updated to the PC of this one.
+/// @param record [out] The decoded record.
+/// @return `true` if a complete, valid record was decoded.
+inline bool DecodeBinaryRecord(const char *&cursor, const char *end, uint64_t &previousPc, TraceRecord &record)
+{
+    const uint8_t *in = (const uint8_t*)cursor;
+    const uint8_t *inEnd = (const uint8_t*)end;
+    if (in == inEnd || (*in & CONTROL_RESERVED_MASK) != 0)
+    {
+        return false;
+    }
+    uint8_t control = *in++;
+    record.OpType = control & CONTROL_OP_TYPE_MASK;
+
+    if (control & CONTROL_PC_DELTA_IS_4)
+    {
+        record.ProgramCounter = previousPc + 4;
+    }
+    else
+    {
+        uint64_t zigzag = 0;
+        int shift = 0;
+        do
+        {
+            if (in == inEnd || shift > 63)
+            {
+                return false;
+            }
+            zigzag |= (uint64_t)(*in & 0x7F) << shift;
+            shift += 7;
+        } while (*in++ & 0x80);
+        record.ProgramCounter = previousPc + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+    }
+
+    if (control & CONTROL_WIDE_REGISTERS)
+    {
+        if (inEnd - in < 12)
+        {
+            return false;
+        }
+        record.DestinationRegister = (int32_t)LoadLittleEndian(in, 4);
+        record.SourceRegister1 = (int32_t)LoadLittleEndian(in + 4, 4);
+        record.SourceRegister2 = (int32_t)LoadLittleEndian(in + 8, 4);
+        in += 12;
+    }
+    else
+    {
+        if (inEnd - in < 3)
+        {
+            return false;
+        }
+        record.DestinationRegister = in[0] == 0xFF ? -1 : in[0];
+        record.SourceRegister1 = in[1] == 0xFF ? -1 : in[1];
+        record.SourceRegister2 = in[2] == 0xFF ? -1 : in[2];
+        in += 3;
+    }
+
+    previousPc = record.ProgramCounter;
+    cursor = (const char*)in;
+    return true;
+}
+
+/// @class BinaryTraceWriter
+/// @brief Writes records in the binary trace format.
+class BinaryTraceWriter
+{
+    public:
+        BinaryTraceWriter() : buffer(1 << 20)
+        {
+        }
+
+        ~BinaryTraceWriter()
+        {
+            Close();
+        }
+
+        BinaryTraceWriter(const BinaryTraceWriter&) = delete;
+        BinaryTraceWriter& operator=(const BinaryTraceWriter&) = delete;
+
+        /// @brief Creates the output file and reserves room for the header.
+        /// @param fileName Path of the binary trace to write.
+        bool Open(const char *fileName)
+        {
+            outputFile = fopen(fileName, "wb");
+            if (outputFile == NULL)
+            {
+                return false;
+            }
+            return WriteHeader();
+        }
+
+        /// @brief Appends a record to the trace.
+        /// @param record The record to append.
+        /// @return `false` if the record cannot be encoded.
+        bool Write(const TraceRecord &record)
+        {
+            if (buffer.size() - usedBytes < MaxBinaryRecordSize)
+            {
+                Flush();
+            }
+            size_t encoded = EncodeBinaryRecord(record, previousPc, &buffer[usedBytes]);
+            usedBytes += encoded;
+            recordCount += encoded != 0;
+            return encoded != 0;
+        }
+
+        /// @brief Flushes the records and finalizes the header.
+        /// @return `true` if everything was written.
+        bool Close()
+        {
+            if (outputFile == NULL)
+            {
+                return true;
+            }
+            Flush();
+            bool written = fseek(outputFile, 0, SEEK_SET) == 0 && WriteHeader() && !ferror(outputFile);
+            written = fclose(outputFile) == 0 && written;
+            outputFile = NULL;
+            return written;
+        }
+
+        /// @brief Gets the number of records written so far.
+        uint64_t GetRecordCount()
+        {
+            return recordCount;
+        }
+
+    private:
+        FILE *outputFile = NULL;
+        vector<uint8_t> buffer;
+        size_t usedBytes = 0;
+        uint64_t previousPc = 0;
+        uint64_t recordCount = 0;
+
+        bool WriteHeader()
+        {
+            uint8_t header[BinaryTraceHeaderSize];
+            memcpy(header, BinaryTraceMagic, sizeof(BinaryTraceMagic));
+            StoreLittleEndian(header + 8, BinaryTraceVersion, 4);
+            StoreLittleEndian(header + 12, 0, 4);
+            StoreLittleEndian(header + 16, recordCount, 8);
+            return fwrite(header, 1, sizeof(header), outputFile) == sizeof(header);
+        }
+
+        void Flush()
+        {
+            fwrite(buffer.data(), 1, usedBytes, outputFile);
+            usedBytes = 0;
+        }
+};
+
+#endif
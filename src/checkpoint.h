@@ -0,0 +1,386 @@
+#ifndef CHECKPOINT_H   // Include guard to prevent multiple inclusions
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "sim.h"
+#include "trace_source.h"
+#include "out_of_order_scheduler.h"
+
+using namespace std;
+
+// Checkpoints hold the raw bytes of the simulator structures, so they can
+// only be restored by a build for the same platform and with the same
+// processor configuration.
+const char CheckpointMagic[8] = {'O', 'O', 'O', 'C', 'K', 'P', '1', '1'};
+
+/// @brief Processor configuration and position stored at the start of a checkpoint.
+/// The execution latency of each op type follows it, OpTypeCount ints.
+struct CheckpointHeader
+{
+    char Magic[8];
+    uint64_t RobSize;
+    uint64_t IqSize;
+    uint64_t Width;
+    uint64_t ArchitecturalRegisters;
+    uint64_t OpTypeCount;
+    uint64_t Cycle;
+    uint64_t FetchedInstructions;
+    uint64_t RetiredInstructions;
+    uint64_t HasTracePosition;
+    TracePosition Trace;            // Next record to fetch, if the trace can seek
+};
+
+/// @class CheckpointWriter
+/// @brief Archive that saves simulator state to a checkpoint file.
+/// Structures describe their state once in a Transfer(archive) method,
+/// which is used with both this class and CheckpointReader.
+class CheckpointWriter
+{
+    public:
+        ~CheckpointWriter()
+        {
+            if (checkpointFile != NULL)
+            {
+                fclose(checkpointFile);
+            }
+        }
+
+        /// @brief Starts writing a checkpoint.
+        /// The data goes to a temporary file that only replaces the
+        /// checkpoint once Close() succeeds, so an interrupted write never
+        /// destroys the previous checkpoint.
+        /// @param fileName Path of the checkpoint.
+        bool Open(const char *fileName)
+        {
+            finalName = fileName;
+            temporaryName = finalName + ".tmp";
+            checkpointFile = fopen(temporaryName.c_str(), "wb");
+            failed = checkpointFile == NULL;
+            return !failed;
+        }
+
+        /// @brief Finishes the checkpoint and moves it into place.
+        bool Close()
+        {
+            if (checkpointFile == NULL)
+            {
+                return false;
+            }
+            failed = fclose(checkpointFile) != 0 || failed;
+            checkpointFile = NULL;
+            return !failed && rename(temporaryName.c_str(), finalName.c_str()) == 0;
+        }
+
+        template <typename T>
+        void Value(T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values are stored as bytes");
+            Array(&value, 1);
+        }
+
+        template <typename T>
+        void Array(T *values, size_t count)
+        {
+            if (!failed && count != 0)
+            {
+                failed = fwrite(values, sizeof(T), count, checkpointFile) != count;
+            }
+        }
+
+        template <typename T>
+        void Vector(vector<T> &values)
+        {
+            uint64_t count = values.size();
+            Value(count);
+            Array(values.data(), values.size());
+        }
+
+        template <typename T>
+        void Vector(vector<vector<T>> &values)
+        {
+            uint64_t count = values.size();
+            Value(count);
+            for (auto &value : values)
+            {
+                Vector(value);
+            }
+        }
+
+    private:
+        FILE *checkpointFile = NULL;
+        string finalName;
+        string temporaryName;
+        bool failed = false;
+};
+
+/// @class CheckpointReader
+/// @brief Archive that restores simulator state from a checkpoint file.
+class CheckpointReader
+{
+    public:
+        ~CheckpointReader()
+        {
+            if (checkpointFile != NULL)
+            {
+                fclose(checkpointFile);
+            }
+        }
+
+        /// @brief Opens a checkpoint for reading.
+        /// @param fileName Path of the checkpoint.
+        bool Open(const char *fileName)
+        {
+            checkpointFile = fopen(fileName, "rb");
+            failed = checkpointFile == NULL;
+            return !failed;
+        }
+
+        /// @brief Gets whether every read so far succeeded.
+        bool IsValid()
+        {
+            return !failed;
+        }
+
+        template <typename T>
+        void Value(T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values are stored as bytes");
+            Array(&value, 1);
+        }
+
+        template <typename T>
+        void Array(T *values, size_t count)
+        {
+            if (!failed && count != 0)
+            {
+                failed = fread(values, sizeof(T), count, checkpointFile) != count;
+            }
+        }
+
+        template <typename T>
+        void Vector(vector<T> &values)
+        {
+            uint64_t count = 0;
+            Value(count);
+            if (failed || count > MaxElements)
+            {
+                failed = true;
+                return;
+            }
+            values.resize(count);
+            Array(values.data(), values.size());
+        }
+
+        template <typename T>
+        void Vector(vector<vector<T>> &values)
+        {
+            uint64_t count = 0;
+            Value(count);
+            if (failed || count > MaxElements)
+            {
+                failed = true;
+                return;
+            }
+            values.resize(count);
+            for (auto &value : values)
+            {
+                Vector(value);
+            }
+        }
+
+    private:
+        // Guards against huge allocations when reading a corrupt checkpoint.
+        static const uint64_t MaxElements = 1ULL << 32;
+
+        FILE *checkpointFile = NULL;
+        bool failed = false;
+};
+
+/// @brief Tells the simulation loop when to write a checkpoint.
+/// Specified as "cycle:N" or "instruction:N" for a single checkpoint once
+/// that many cycles have elapsed or instructions have retired, or as
+/// "every:N" to rewrite the checkpoint every N cycles.
+class CheckpointSchedule
+{
+    public:
+        /// @brief Parses the checkpoint specification.
+        bool Parse(const char *specification)
+        {
+            char kindText[16];
+            unsigned long long value;
+            char extra;
+            if (sscanf(specification, "%15[a-z]:%llu%c", kindText, &value, &extra) != 2 || value == 0)
+            {
+                return false;
+            }
+            string kindName = kindText;
+            if (kindName == "cycle")
+            {
+                kind = AtCycle;
+            }
+            else if (kindName == "instruction")
+            {
+                kind = AtInstruction;
+            }
+            else if (kindName == "every")
+            {
+                kind = EveryCycles;
+            }
+            else
+            {
+                return false;
+            }
+            interval = value;
+            nextCycle = value;
+            return true;
+        }
+
+        /// @brief Gets whether a checkpoint should be written now.
+        /// Fast-forwarding can skip cycles, so a checkpoint is due at the
+        /// first cycle boundary at or after the requested point.
+        /// @param cycle Cycles simulated so far.
+        /// @param retiredInstructions Instructions retired so far.
+        bool IsDue(uint64_t cycle, uint64_t retiredInstructions)
+        {
+            switch (kind)
+            {
+                case AtCycle:
+                case EveryCycles:
+                    if (cycle < nextCycle)
+                    {
+                        return false;
+                    }
+                    nextCycle = kind == EveryCycles ? cycle + interval : UINT64_MAX;
+                    return true;
+                case AtInstruction:
+                    if (retiredInstructions < interval)
+                    {
+                        return false;
+                    }
+                    kind = None;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+    private:
+        enum Kind { None, AtCycle, AtInstruction, EveryCycles };
+        Kind kind = None;
+        uint64_t interval = 0;
+        uint64_t nextCycle = 0;
+};
+
+/// @brief Writes the complete scheduler state to a checkpoint.
+/// @param fileName Path of the checkpoint.
+/// @param scheduler Scheduler between two cycles.
+/// @param params Processor configuration of the scheduler.
+/// @param traceSource Trace the scheduler fetches from.
+template <typename SchedulerType>
+bool SaveCheckpoint(const char *fileName, SchedulerType &scheduler, const proc_params &params,
+                    TraceSource *traceSource)
+{
+    CheckpointWriter writer;
+    CheckpointHeader header = {};
+    memcpy(header.Magic, CheckpointMagic, sizeof(header.Magic));
+    header.RobSize = params.rob_size;
+    header.IqSize = params.iq_size;
+    header.Width = params.width;
+    header.ArchitecturalRegisters = scheduler.RMT.GetRegisterCount();
+    header.OpTypeCount = scheduler.GetLatencyTable().size();
+    header.Cycle = scheduler.CurrentCyclesCount;
+    header.FetchedInstructions = scheduler.FetchedInstructionsCount;
+    header.RetiredInstructions = scheduler.RetiredInstructionsCount;
+    header.HasTracePosition = traceSource->TryGetPosition(header.Trace);
+
+    if (!writer.Open(fileName))
+    {
+        return false;
+    }
+    vector<int> latencies = scheduler.GetLatencyTable();
+    writer.Value(header);
+    writer.Array(latencies.data(), latencies.size());
+    scheduler.Transfer(writer);
+    return writer.Close();
+}
+
+/// @brief Restores the scheduler state from a checkpoint and moves the
+/// trace source to the first instruction not yet fetched.
+/// @param fileName Path of the checkpoint.
+/// @param scheduler Freshly constructed scheduler with the same configuration.
+/// @param params Processor configuration of the scheduler.
+/// @param traceSource Trace the checkpoint was taken from, at its start.
+/// @param error [out] Reason for a failure.
+template <typename SchedulerType>
+bool RestoreCheckpoint(const char *fileName,
+                       SchedulerType &scheduler,
+                       const proc_params &params,
+                       TraceSource *traceSource,
+                       string &error)
+{
+    CheckpointReader reader;
+    CheckpointHeader header;
+    if (!reader.Open(fileName))
+    {
+        error = "unable to open the checkpoint";
+        return false;
+    }
+    reader.Value(header);
+    if (!reader.IsValid() || memcmp(header.Magic, CheckpointMagic, sizeof(header.Magic)) != 0)
+    {
+        error = "not a checkpoint file";
+        return false;
+    }
+    if (header.RobSize != params.rob_size || header.IqSize != params.iq_size || header.Width != params.width)
+    {
+        error = "the checkpoint was taken with ROB_SIZE " + to_string(header.RobSize)
+            + ", IQ_SIZE " + to_string(header.IqSize) + " and WIDTH " + to_string(header.Width);
+        return false;
+    }
+    if (header.ArchitecturalRegisters != scheduler.RMT.GetRegisterCount())
+    {
+        error = "the checkpoint was taken with " + to_string(header.ArchitecturalRegisters)
+            + " architectural registers";
+        return false;
+    }
+    vector<int> latencies(scheduler.GetLatencyTable().size());
+    if (header.OpTypeCount == latencies.size())
+    {
+        reader.Array(latencies.data(), latencies.size());
+    }
+    if (header.OpTypeCount != latencies.size() || !reader.IsValid() || latencies != scheduler.GetLatencyTable())
+    {
+        error = "the checkpoint was taken with different op type latencies";
+        return false;
+    }
+    scheduler.Transfer(reader);
+    if (!reader.IsValid())
+    {
+        error = "the checkpoint is truncated or corrupt";
+        return false;
+    }
+
+    // Seek straight to the next record when the trace allows it; a trace
+    // read from a pipe is read up to the checkpointed position instead.
+    if (header.HasTracePosition != 0 && traceSource->Seek(header.Trace))
+    {
+        return true;
+    }
+    TraceRecord record;
+    for (uint64_t i = 0; i < scheduler.FetchedInstructionsCount; i++)
+    {
+        if (!traceSource->TryGetNext(record))
+        {
+            error = "the trace is shorter than the checkpointed position";
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef DECODE_THREAD_H   // Include guard to prevent multiple inclusions
+#define DECODE_THREAD_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "sim.h"
+#include "trace_source.h"
+
+using namespace std;
+
+/// @class DecodeThread
+/// @brief Decodes a trace on a separate thread, ahead of fetch.
+/// The producer thread pulls records from the wrapped source into a bounded
+/// single-producer/single-consumer ring and waits while the ring is full.
+/// Fetch pops from the ring and only waits when the producer has fallen
+/// behind, so on a machine with a spare core trace decoding overlaps with
+/// the simulation.
+class DecodeThread : public TraceSource
+{
+    public:
+        /// Ring depth used when none is requested.
+        static const size_t DefaultDepth = 16384;
+
+        DecodeThread()
+        {
+        }
+
+        ~DecodeThread()
+        {
+            Stop();
+        }
+
+        DecodeThread(const DecodeThread&) = delete;
+        DecodeThread& operator=(const DecodeThread&) = delete;
+
+        /// @brief Starts decoding the source on the producer thread.
+        /// @param source Trace to decode. Only the producer thread reads it
+        /// until the end of the trace has been reached.
+        /// @param depth Number of records the ring holds, rounded up to a power of two.
+        void Start(TraceSource *source, size_t depth = DefaultDepth)
+        {
+            Stop();
+            size_t capacity = 1;
+            while (capacity < depth)
+            {
+                capacity *= 2;
+            }
+            ring.assign(capacity, TraceRecord());
+            mask = capacity - 1;
+            consumerPosition.store(0, memory_order_relaxed);
+            producerPosition.store(0, memory_order_relaxed);
+            readPosition = 0;
+            knownProducerPosition = 0;
+            finished.store(false, memory_order_relaxed);
+            stopRequested.store(false, memory_order_relaxed);
+            producer = thread([this, source]() { Produce(source); });
+        }
+
+        /// @brief Attempts to get the next decoded trace record.
+        /// @param record [out] Reference where the next record will be stored if available.
+        /// @return `true` if a record was available, `false` at the end of the trace.
+        bool TryGetNext(TraceRecord &record) override
+        {
+            if (readPosition == knownProducerPosition && !WaitForRecords())
+            {
+                return false;
+            }
+            record = ring[readPosition & mask];
+            readPosition++;
+            consumerPosition.store(readPosition, memory_order_release);
+            return true;
+        }
+
+        /// @brief Gets whether every record of the trace has been handed out.
+        bool IsExhausted() override
+        {
+            return readPosition == knownProducerPosition && !WaitForRecords();
+        }
+
+    private:
+        vector<TraceRecord> ring;
+        size_t mask = 0;
+        thread producer;
+        atomic<bool> finished{false};
+        atomic<bool> stopRequested{false};
+
+        // Each side writes its own position and only reads the other one
+        // when its cached copy runs out, so the two rarely share a cache line.
+        alignas(64) atomic<size_t> consumerPosition{0};
+        size_t readPosition = 0;
+        size_t knownProducerPosition = 0;
+        alignas(64) atomic<size_t> producerPosition{0};
+
+        void Produce(TraceSource *source)
+        {
+            size_t writePosition = 0;
+            size_t knownConsumerPosition = 0;
+            TraceRecord record;
+            while (source->TryGetNext(record))
+            {
+                while (writePosition - knownConsumerPosition == ring.size())
+                {
+                    knownConsumerPosition = consumerPosition.load(memory_order_acquire);
+                    if (writePosition - knownConsumerPosition != ring.size())
+                    {
+                        break;
+                    }
+                    if (stopRequested.load(memory_order_relaxed))
+                    {
+                        return;
+                    }
+                    this_thread::yield();
+                }
+                ring[writePosition & mask] = record;
+                writePosition++;
+                producerPosition.store(writePosition, memory_order_release);
+            }
+            finished.store(true, memory_order_release);
+        }
+
+        /// @brief Waits until the producer publishes a record or reaches the end of the trace.
+        /// @return `true` if a record is available.
+        bool WaitForRecords()
+        {
+            while (true)
+            {
+                knownProducerPosition = producerPosition.load(memory_order_acquire);
+                if (knownProducerPosition != readPosition)
+                {
+                    return true;
+                }
+                if (finished.load(memory_order_acquire))
+                {
+                    // Records published just before the end of the trace.
+                    knownProducerPosition = producerPosition.load(memory_order_acquire);
+                    return knownProducerPosition != readPosition;
+                }
+                this_thread::yield();
+            }
+        }
+
+        void Stop()
+        {
+            if (producer.joinable())
+            {
+                stopRequested.store(true, memory_order_relaxed);
+                producer.join();
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef DESIGN_SWEEP_H   // Include guard to prevent multiple inclusions
+#define DESIGN_SWEEP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "sim.h"
+#include "trace_source.h"
+#include "simulator.h"
+#include "work_stealing_pool.h"
+
+using namespace std;
+
+/// @brief Summary of one simulated processor configuration.
+struct SweepResult
+{
+    uint64_t Instructions = 0;
+    uint64_t Cycles = 0;
+};
+
+/// @brief Gets whether a configuration can make progress.
+/// Rename and dispatch move whole bundles, so a ROB or IQ smaller than
+/// WIDTH would stall forever.
+inline bool IsConfigurationSimulatable(const proc_params &params)
+{
+    return params.width != 0 && params.rob_size >= params.width && params.iq_size >= params.width;
+}
+
+/// @brief Parses a comma separated list of positive numbers.
+inline bool ParseSizeList(const string &text, vector<unsigned long> &values)
+{
+    size_t start = 0;
+    while (start <= text.size())
+    {
+        size_t end = text.find(',', start);
+        if (end == string::npos)
+        {
+            end = text.size();
+        }
+        string item = text.substr(start, end - start);
+        char *itemEnd;
+        unsigned long value = strtoul(item.c_str(), &itemEnd, 10);
+        if (item.empty() || *itemEnd != '\0' || value == 0)
+        {
+            return false;
+        }
+        values.push_back(value);
+        start = end + 1;
+    }
+    return true;
+}
+
+/// @brief Parses the configurations of a design-space sweep.
+/// The specification is either a grid "ROB_LIST:IQ_LIST:WIDTH_LIST" of comma
+/// separated values, for example "32,64:8,16:2,4", or the path of a file with
+/// one "ROB_SIZE IQ_SIZE WIDTH" triple per line ('#' starts a comment).
+/// Grid points whose ROB or IQ is smaller than WIDTH are skipped.
+/// @param specification Grid or file path.
+/// @param configurations [out] Configurations in the order they are reported.
+/// @return `true` if the specification was valid.
+inline bool ParseSweepConfigurations(const char *specification, vector<proc_params> &configurations)
+{
+    string text = specification;
+    size_t firstColon = text.find(':');
+    if (firstColon != string::npos)
+    {
+        size_t secondColon = text.find(':', firstColon + 1);
+        vector<unsigned long> robSizes, iqSizes, widths;
+        if (secondColon == string::npos
+            || !ParseSizeList(text.substr(0, firstColon), robSizes)
+            || !ParseSizeList(text.substr(firstColon + 1, secondColon - firstColon - 1), iqSizes)
+            || !ParseSizeList(text.substr(secondColon + 1), widths))
+        {
+            return false;
+        }
+        for (unsigned long robSize : robSizes)
+        {
+            for (unsigned long iqSize : iqSizes)
+            {
+                for (unsigned long width : widths)
+                {
+                    proc_params params = {robSize, iqSize, width};
+                    if (IsConfigurationSimulatable(params))
+                    {
+                        configurations.push_back(params);
+                    }
+                }
+            }
+        }
+        return !configurations.empty();
+    }
+
+    FILE *file = fopen(specification, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+    char line[256];
+    bool valid = true;
+    while (valid && fgets(line, sizeof(line), file) != NULL)
+    {
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+        {
+            *comment = '\0';
+        }
+        proc_params params;
+        char extra;
+        int fields = sscanf(line, "%lu %lu %lu %c", &params.rob_size, &params.iq_size, &params.width, &extra);
+        if (fields == EOF)
+        {
+            continue;
+        }
+        valid = fields == 3 && IsConfigurationSimulatable(params);
+        configurations.push_back(params);
+    }
+    fclose(file);
+    return valid && !configurations.empty();
+}
+
+/// @brief Simulates every configuration against one decoded trace.
+/// Each configuration runs its own Simulator that replays the shared,
+/// read-only records, so the trace is decoded only once.
+/// @param records Decoded trace.
+/// @param configurations Processor configurations to simulate.
+/// @param opTypeByLatency Execution latency of each op type.
+/// @param threadCount Number of worker threads.
+/// @param results [out] One result per configuration, in the same order.
+inline void RunDesignSweep(const vector<TraceRecord> &records,
+                           const vector<proc_params> &configurations,
+                           const map<int, int> &opTypeByLatency,
+                           unsigned threadCount,
+                           vector<SweepResult> &results)
+{
+    results.assign(configurations.size(), SweepResult());
+    vector<size_t> jobs(configurations.size());
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        jobs[i] = i;
+    }
+
+    WorkStealingPool pool(threadCount);
+    pool.Run(jobs, [&](size_t job)
+    {
+        SimulatorConfig config;
+        config.Params = configurations[job];
+        config.OpTypeByLatency = opTypeByLatency;
+        Simulator simulator(config);
+        simulator.SetTrace(records.data(), records.size());
+        simulator.Run();
+        SimulatorStats stats = simulator.GetStats();
+        results[job].Instructions = stats.Instructions;
+        results[job].Cycles = stats.Cycles;
+    });
+}
+
+/// @brief Writes one CSV row per configuration.
+inline void PrintSweepResults(FILE *file, const vector<proc_params> &configurations, const vector<SweepResult> &results)
+{
+    fprintf(file, "rob_size,iq_size,width,instructions,cycles,ipc\n");
+    for (size_t i = 0; i < configurations.size(); i++)
+    {
+        fprintf(file, "%lu,%lu,%lu,%" PRIu64 ",%" PRIu64 ",%.4f\n",
+            configurations[i].rob_size,
+            configurations[i].iq_size,
+            configurations[i].width,
+            results[i].Instructions,
+            results[i].Cycles,
+            results[i].Cycles == 0 ? 0.0 : (double)results[i].Instructions / results[i].Cycles);
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef FIXED_CAPACITY_H   // Include guard to prevent multiple inclusions
+#define FIXED_CAPACITY_H
+
+#include <array>
+#include <vector>
+
+using namespace std;
+
+/// @class Capacity
+/// @brief Size of a pipeline structure, fixed at compile time when the
+/// template argument is non-zero. A fixed size lets the compiler unroll
+/// loops bounded by it and turn index wrapping into masks.
+template <unsigned long Fixed>
+class Capacity
+{
+    public:
+        Capacity(unsigned long) {}
+
+        constexpr unsigned long Get() const
+        {
+            return Fixed;
+        }
+};
+
+/// @brief Size of a pipeline structure chosen at run time.
+template <>
+class Capacity<0>
+{
+    public:
+        Capacity(unsigned long size) : value(size) {}
+
+        unsigned long Get() const
+        {
+            return value;
+        }
+
+    private:
+        unsigned long value;
+};
+
+/// @class CapacityArray
+/// @brief Storage of a pipeline structure: a std::array when the size is
+/// fixed at compile time and a vector otherwise.
+template <typename T, unsigned long Fixed>
+class CapacityArray
+{
+    public:
+        CapacityArray(unsigned long, const T &initialValue = T())
+        {
+            values.fill(initialValue);
+        }
+
+        T& operator[](unsigned long index) { return values[index]; }
+        const T& operator[](unsigned long index) const { return values[index]; }
+        T* data() { return values.data(); }
+        constexpr unsigned long size() const { return Fixed; }
+        T* begin() { return values.data(); }
+        T* end() { return values.data() + Fixed; }
+
+    private:
+        std::array<T, Fixed> values;
+};
+
+template <typename T>
+class CapacityArray<T, 0>
+{
+    public:
+        CapacityArray(unsigned long size, const T &initialValue = T()) : values(size, initialValue) {}
+
+        T& operator[](unsigned long index) { return values[index]; }
+        const T& operator[](unsigned long index) const { return values[index]; }
+        T* data() { return values.data(); }
+        unsigned long size() const { return values.size(); }
+        T* begin() { return values.data(); }
+        T* end() { return values.data() + values.size(); }
+
+    private:
+        vector<T> values;
+};
+
+#endif
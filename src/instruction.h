@@ -2,7 +2,10 @@
 #define INSTRUCTION_H
 
 #include <inttypes.h>
+#include <array>
 #include <string>
+#include <type_traits>
+#include "sim.h"
 
 using namespace std;
 
@@ -13,7 +16,6 @@ class Register {
         int Value;
         bool HasRobValue = false;
         bool Exist = false;
-        bool IsReady = false;
 };
 
 /// @class Instruction
@@ -24,8 +26,7 @@ class Instruction
         int OpType = -1;
         int RobValue; // Rob value of an instruction. Specific to Reorder buffer
         int Latency = -1;
-        bool InstructionValidInIQ = false;
-        unsigned long InstructionSequenceNumber = -1;
+        uint64_t InstructionSequenceNumber = -1;
 
         uint64_t ProgramCounter = 0;
         Register SourceRegister1;
@@ -34,7 +35,8 @@ class Instruction
 
         /// Contains cycle information for each pipeline stages
         // Pipeline stages: FE, DE, RN, RR, DI, IS, EX, WB and RT
-        std::map<PipelineRegister, CycleInfo> registerCycles;
+        int64_t FetchCycle = 0;
+        std::array<CycleInfo, TotalPipelineRegisters> registerCycles;
 
         /// @brief Constructs Instruction class which is used in each piepline stages
         Instruction(uint64_t programCounter, 
@@ -42,8 +44,8 @@ class Instruction
                     Register destinationRegister, 
                     Register sourceRegister1, 
                     Register sourceRegister2, 
-                    unsigned long sequenceNumber,
-                    unsigned long initialCycle)
+                    uint64_t sequenceNumber,
+                    uint64_t initialCycle)
         {
             ProgramCounter = programCounter;
             DestinationRegister = destinationRegister;
@@ -51,79 +53,54 @@ class Instruction
             SourceRegister1 = sourceRegister1;
             SourceRegister2 = sourceRegister2;
             InstructionSequenceNumber = sequenceNumber;
+            FetchCycle = initialCycle;
 
-            registerCycles[PipelineRegister::FE].start = initialCycle;
-            registerCycles[PipelineRegister::FE].finish = -1;
-
-            registerCycles[PipelineRegister::DE].start = -1;
-            registerCycles[PipelineRegister::DE].finish = -1;
-
-            registerCycles[PipelineRegister::RN].start = -1;
-            registerCycles[PipelineRegister::RN].finish = -1;
-
-            registerCycles[PipelineRegister::RR].start = -1;
-            registerCycles[PipelineRegister::RR].finish = -1;
-
-            registerCycles[PipelineRegister::DI].start = -1;
-            registerCycles[PipelineRegister::DI].finish = -1;
-
-            registerCycles[PipelineRegister::IS].start = -1;
-            registerCycles[PipelineRegister::IS].finish = -1;
-
-            registerCycles[PipelineRegister::EX].start = -1;
-            registerCycles[PipelineRegister::EX].finish = -1;
-
-            registerCycles[PipelineRegister::WB].start = -1;
-            registerCycles[PipelineRegister::WB].finish = -1;
-
-            registerCycles[PipelineRegister::RT].start = -1;
-            registerCycles[PipelineRegister::RT].finish = -1;
-        }
-
-        Instruction() {};
-
-        /// @brief Attempts to get the ROB value for the destination register.
-        /// @param robValue [out] Reference to an integer where the ROB value will be stored if available.
-        /// @return `true` if the destination register has a valid ROB value, `false` otherwise.
-        bool TryGetDestinationRegisterRobValue(int &robValue)
-        {
-            if (DestinationRegister.HasRobValue)
+            for (auto &cycleInfo : registerCycles)
             {
-                robValue = DestinationRegister.Value;
-                return true;
+                cycleInfo.start = -1;
+                cycleInfo.finish = -1;
             }
-            return false;
+            registerCycles[PipelineRegister::FE].start = 0;
         }
 
+        Instruction() {};
+
         /// @brief Sets the start cycle for a specific pipeline register.
         /// @param registerVal The pipeline register for which the start cycle is to be set.
         /// @param cycleValue The cycle value to set as the start cycle.
-        void SetBeginCycleForRegister(PipelineRegister registerVal, int cycleValue)
+        void SetBeginCycleForRegister(PipelineRegister registerVal, int64_t cycleValue)
         {
-            registerCycles[registerVal].start = cycleValue;
+            registerCycles[registerVal].start = cycleValue - FetchCycle;
         }
         
         /// @brief Sets the end cycle for a specific pipeline register.
         /// @param registerVal The pipeline register for which the end cycle is to be set.
         /// @param cycleValue The cycle value to set as the end cycle.
-        void SetEndCycleForRegister(PipelineRegister registerVal, int cycleValue)
+        void SetEndCycleForRegister(PipelineRegister registerVal, int64_t cycleValue)
         {
             registerCycles[registerVal].finish = cycleValue;
         }
 
         /// @brief Gets the start cycle for a specific pipeline register.
         /// @param registerVal The pipeline register for which the start cycle is to be obtained.
-        int GetBeginCycleValueForRegister(PipelineRegister registerVal)
+        int64_t GetBeginCycleValueForRegister(PipelineRegister registerVal) const
         {
-            return registerCycles[registerVal].start;
+            if (registerCycles[registerVal].start == -1)
+            {
+                return -1;
+            }
+            return FetchCycle + registerCycles[registerVal].start;
         }
         
         /// @brief Gets the end cycle for a specific pipeline register.
         /// @param registerVal The pipeline register for which the end cycle is to be obtained.
-        int GetEndCycleValueForRegister(PipelineRegister registerVal)
+        int GetEndCycleValueForRegister(PipelineRegister registerVal) const
         {
             return registerCycles[registerVal].finish;
         }
 };
 
+static_assert(std::is_trivially_copyable<Instruction>::value,
+              "Checkpoints store the InstructionArena byte-wise, so Instruction must stay trivially copyable");
+
 #endif
\ No newline at end of file
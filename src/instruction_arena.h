@@ -0,0 +1,66 @@
+#ifndef INSTRUCTION_ARENA_H   // Include guard to prevent multiple inclusions
+#define INSTRUCTION_ARENA_H
+
+#include "instruction.h"
+#include "fixed_capacity.h"
+
+using namespace std;
+
+/// @class InstructionArena
+/// @brief Pool that holds every in-flight instruction exactly once.
+/// Fetch allocates an entry and retire releases it; in between, the latches,
+/// the issue queue and the ROB only pass the index of the entry around. A
+/// non-zero FixedSize fixes the number of entries at compile time.
+template <unsigned long FixedSize = 0>
+class InstructionArena
+{
+    public:
+        InstructionArena(unsigned long size) : instructions(size), freeIndices(size), freeCount(size)
+        {
+            // Hand out low indices first.
+            for (unsigned long i = 0; i < size; i++)
+            {
+                freeIndices[i] = size - 1 - i;
+            }
+        }
+
+        /// @brief Stores an instruction in a free entry.
+        /// @param instruction The fetched instruction.
+        /// @return Index of the entry holding the instruction.
+        int Allocate(const Instruction &instruction)
+        {
+            int index = freeIndices[--freeCount];
+            instructions[index] = instruction;
+            return index;
+        }
+
+        /// @brief Frees the entry of a retired instruction.
+        /// @param index Index of the entry.
+        void Release(int index)
+        {
+            freeIndices[freeCount++] = index;
+        }
+
+        /// @brief Gets the instruction stored at the index.
+        /// @param index Index of the entry.
+        Instruction& operator[](int index)
+        {
+            return instructions[index];
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Array(instructions.data(), instructions.size());
+            archive.Array(freeIndices.data(), freeIndices.size());
+            archive.Value(freeCount);
+        }
+
+    private:
+        CapacityArray<Instruction, FixedSize> instructions;
+        CapacityArray<int, FixedSize> freeIndices;
+        unsigned long freeCount;
+};
+
+#endif
@@ -1,100 +1,92 @@
 #ifndef INSTRUCTIONS_TABLE_H   // Include guard to prevent multiple inclusions
 #define INSTRUCTIONS_TABLE_H
 
-#include <queue>
-#include "instruction.h"
+#include "fixed_capacity.h"
 
 using namespace std;
 
 /// @class InstructionsTable
 /// @brief Base class that contains queue of instructions.
+/// The queue is a ring of InstructionArena indices over storage sized once
+/// at construction, so moving an instruction between latches only copies
+/// its index. A non-zero FixedSize fixes the capacity at compile time.
+template <unsigned long FixedSize = 0>
 class InstructionsTable
 {
     public:
-        std::queue<Instruction> InstructionsQueue;
-
-        InstructionsTable(unsigned long queue_size)
+        InstructionsTable(unsigned long queue_size) : size(queue_size), instructions(queue_size)
         {
-            size = queue_size;
         }
-        
+
         /// @brief Pushes instruction at the end of the queue.
-        /// @param instruction Instruction to be pushed
-        void PushInstruction(Instruction instruction)
+        /// @param instructionIndex Arena index of the instruction to be pushed
+        void PushInstruction(int instructionIndex)
         {
-            if (InstructionsQueue.size() >= size)
+            if (count >= size.Get())
             {
                 return;
             }
-            InstructionsQueue.push(instruction);
+            instructions[Wrap(headIndex + count)] = instructionIndex;
+            count++;
         }
-        
+
         /// @brief Removes instruction at the head of the queue.
-        /// @param instruction Instruction to be popped
         void PopInstruction()
         {
-            InstructionsQueue.pop();
+            headIndex = Wrap(headIndex + 1);
+            count--;
         }
 
-        /// @brief Gets the head instruction of the queue.
-        Instruction Front()
+        /// @brief Gets the arena index of the head instruction of the queue.
+        int Front()
         {
-            return InstructionsQueue.front();
+            return instructions[headIndex];
         }
-        
+
         /// @brief Gets the size of the queue.
         unsigned long GetSize()
         {
-            return InstructionsQueue.size();
+            return count;
         }
 
         /// @brief Gets whether the queue is empty or not.
         bool IsEmpty()
         {
-            return InstructionsQueue.empty();
+            return count == 0;
         }
 
         /// @brief Gets whether the queue is full or not.
         bool IsFull()
         {
-            return InstructionsQueue.size() == size;
+            return count == size.Get();
         }
-        
+
         /// @brief Gets the free entries of the queue.
         unsigned long GetFreeEntries()
         {
-            return size - InstructionsQueue.size();
+            return size.Get() - count;
         }
 
-        /// @brief Checks and sets the readiness of the source registers
-        /// @param robValue Reorder buffer value
-        void CheckAndWakeupSourceOperandsInInstructions(int robValue)
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
         {
-            std::queue<Instruction> tempQueue;
+            archive.Value(headIndex);
+            archive.Value(count);
+            archive.Array(instructions.data(), instructions.size());
+        }
 
-            // Iterate through the original queue
-            while (!InstructionsQueue.empty()) 
-            {
-                Instruction instruction = InstructionsQueue.front();
-                if (instruction.SourceRegister1.HasRobValue 
-                    && instruction.SourceRegister1.Value == robValue) 
-                {
-                    instruction.SourceRegister1.IsReady = true;
-                }
-                if (instruction.SourceRegister2.HasRobValue 
-                    && instruction.SourceRegister2.Value == robValue) 
-                {
-                    instruction.SourceRegister2.IsReady = true;
-                }
-                tempQueue.push(instruction);
-                InstructionsQueue.pop();
-            }
+    private:
+        Capacity<FixedSize> size;
+        CapacityArray<int, FixedSize> instructions;
+        unsigned long headIndex = 0;
+        unsigned long count = 0;
 
-            InstructionsQueue = tempQueue;
+        // Indices never exceed twice the capacity, so one subtraction wraps them.
+        unsigned long Wrap(unsigned long index)
+        {
+            return index < size.Get() ? index : index - size.Get();
         }
-    
-    public:
-        unsigned long int size = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,80 +1,99 @@
 #ifndef ISSUE_QUEUE_H   // Include guard to prevent multiple inclusions
 #define ISSUE_QUEUE_H
 
-#include <queue>
-#include <string>
-#include <limits>
-#include "instruction.h"
-#include "instructions_table.h"
+#include <inttypes.h>
+#include "fixed_capacity.h"
 
 using namespace std;
 
+/// Marks an issue queue entry that holds no instruction.
+const int FreeIssueQueueEntry = -1;
+
 /// @class IssueQueue
 /// @brief Provides an abstract layer for IssueQueue
+/// Each entry holds the InstructionArena index of an instruction or
+/// FreeIssueQueueEntry. A bitmask tracks the occupied entries, so free
+/// entries are counted with popcount and found with find-first-set instead
+/// of scanning the queue. A non-zero FixedSize fixes the number of entries
+/// at compile time.
+template <unsigned long FixedSize = 0>
 class IssueQueue
 {
     public:
-        Instruction* issueQueue;
-        unsigned long size;
+        CapacityArray<int, FixedSize> issueQueue;
 
-        IssueQueue(int iqSize)
+        IssueQueue(unsigned long iqSize) : issueQueue(iqSize, FreeIssueQueueEntry),
+                                           validBits((iqSize + 63) / 64, 0),
+                                           size(iqSize)
         {
-            size = iqSize;
-            issueQueue = new Instruction[iqSize];
-
-            for (int i = 0; i < size; i++)
-            {
-                Instruction instruction = Instruction();
-                instruction.InstructionValidInIQ = false;
-                issueQueue[i] = instruction;
-            }
         }
 
         /// @brief Gets free issue queue entries
-        int GetFreeIssueQueueEntries()
+        unsigned long GetFreeIssueQueueEntries()
         {
-            int totalFreeEntries = 0;
-            for (int i = 0; i < size; i++)
+            unsigned long occupiedEntries = 0;
+            for (uint64_t bits : validBits)
             {
-                if (issueQueue[i].InstructionValidInIQ == false)
-                {
-                    totalFreeEntries++;
-                }
+                occupiedEntries += __builtin_popcountll(bits);
             }
-            return totalFreeEntries;
+            return size.Get() - occupiedEntries;
         }
 
-        /// @brief Checks and sets the readiness of the source registers
-        /// @param robValue Reorder buffer value
-        void CheckAndWakeupSourceOperandsInInstructions(int robValue)
+        /// @brief Finds whether the issue queue is empty or not
+        bool IsEmpty()
         {
-            for (int i = 0; i < size; i++)
+            for (uint64_t bits : validBits)
             {
-                if (issueQueue[i].SourceRegister1.HasRobValue 
-                    && issueQueue[i].SourceRegister1.Value == robValue) 
+                if (bits != 0)
                 {
-                    issueQueue[i].SourceRegister1.IsReady = true;
-                }
-                if (issueQueue[i].SourceRegister2.HasRobValue 
-                    && issueQueue[i].SourceRegister2.Value == robValue) 
-                {
-                    issueQueue[i].SourceRegister2.IsReady = true;
+                    return false;
                 }
             }
+            return true;
         }
 
-        /// @brief Finds whether the issue queue is empty or not
-        bool IsEmpty()
+        /// @brief Stores an instruction in the lowest free entry. The queue must have a free entry.
+        /// @param instructionIndex Arena index of the instruction.
+        /// @return Index of the issue queue entry holding the instruction.
+        int AddElement(int instructionIndex)
         {
-            return GetFreeIssueQueueEntries() == size;
+            unsigned long word = 0;
+            while (~validBits[word] == 0)
+            {
+                word++;
+            }
+            int index = word * 64 + __builtin_ctzll(~validBits[word]);
+            validBits[word] |= Bit(index);
+            issueQueue[index] = instructionIndex;
+            return index;
         }
 
         /// @brief Sets the validity of the element by index
         /// @param index Index of the issue queue
         void RemoveElementAtIndex(int index)
         {
-            issueQueue[index].InstructionValidInIQ = false;
+            validBits[index / 64] &= ~Bit(index);
+            issueQueue[index] = FreeIssueQueueEntry;
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Array(issueQueue.data(), issueQueue.size());
+            archive.Array(validBits.data(), validBits.size());
+        }
+
+    private:
+        static const unsigned long FixedWords = (FixedSize + 63) / 64;
+
+        CapacityArray<uint64_t, FixedWords> validBits;
+        Capacity<FixedSize> size;
+
+        static uint64_t Bit(int index)
+        {
+            return 1ULL << (index % 64);
         }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,149 @@
+#ifndef ISSUE_SELECTOR_H   // Include guard to prevent multiple inclusions
+#define ISSUE_SELECTOR_H
+
+#include <inttypes.h>
+#include <vector>
+#include "fixed_capacity.h"
+
+using namespace std;
+
+/// @class IssueSelector
+/// @brief Oldest-first select logic for the issue queue.
+/// Entries are tracked in bitmaps indexed by ROB value. The ROB is allocated
+/// in program order, so walking the ready bitmap from the ROB head with
+/// find-first-set yields ready instructions from oldest to youngest without
+/// sorting the issue queue. A non-zero FixedRobSize fixes the bitmap size
+/// at compile time.
+template <unsigned long FixedRobSize = 0>
+class IssueSelector
+{
+    public:
+        IssueSelector(unsigned long robSize) : totalWords((robSize + 63) / 64),
+                                               validBits((robSize + 63) / 64, 0),
+                                               readyBits((robSize + 63) / 64, 0),
+                                               slotByRobValue(robSize, -1)
+        {
+        }
+
+        /// @brief Tracks an instruction dispatched into the issue queue.
+        /// @param robValue Rob value of the instruction.
+        /// @param slot Index of the issue queue entry holding the instruction.
+        /// @param isReady Whether both source operands are already ready.
+        void Insert(int robValue, int slot, bool isReady)
+        {
+            slotByRobValue[robValue] = slot;
+            validBits[robValue / 64] |= Bit(robValue);
+            if (isReady)
+            {
+                readyBits[robValue / 64] |= Bit(robValue);
+            }
+        }
+
+        /// @brief Marks an instruction as ready to issue if it is in the issue queue.
+        /// @param robValue Rob value of the instruction.
+        void MarkReady(int robValue)
+        {
+            readyBits[robValue / 64] |= validBits[robValue / 64] & Bit(robValue);
+        }
+
+        /// @brief Stops tracking an instruction that left the issue queue.
+        /// @param robValue Rob value of the instruction.
+        void Remove(int robValue)
+        {
+            validBits[robValue / 64] &= ~Bit(robValue);
+            readyBits[robValue / 64] &= ~Bit(robValue);
+            slotByRobValue[robValue] = -1;
+        }
+
+        /// @brief Gets whether any instruction in the issue queue is ready to issue.
+        bool HasReadyInstruction()
+        {
+            for (uint64_t bits : readyBits)
+            {
+                if (bits != 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// @brief Gets the number of instructions in the issue queue.
+        unsigned long GetSize()
+        {
+            unsigned long size = 0;
+            for (uint64_t bits : validBits)
+            {
+                size += __builtin_popcountll(bits);
+            }
+            return size;
+        }
+
+        /// @brief Gets the issue queue entry holding the instruction.
+        /// @param robValue Rob value of the instruction.
+        int GetSlot(int robValue)
+        {
+            return slotByRobValue[robValue];
+        }
+
+        /// @brief Collects up to maxCount ready instructions, oldest first.
+        /// @param headRobValue Rob value of the oldest in-flight instruction.
+        /// @param maxCount Maximum number of instructions to select.
+        /// @param selected [out] Rob values of the selected instructions.
+        void SelectOldest(unsigned long headRobValue, unsigned long maxCount, vector<int> &selected)
+        {
+            selected.clear();
+            unsigned long firstWord = headRobValue / 64;
+            uint64_t olderBitsMask = ~0ULL << (headRobValue % 64);
+
+            // Visit the head word twice: its upper bits first and, after
+            // wrapping around the ROB, its lower bits last.
+            for (unsigned long step = 0; step <= totalWords.Get(); step++)
+            {
+                unsigned long word = (firstWord + step) % totalWords.Get();
+                uint64_t bits = readyBits[word];
+                if (step == 0)
+                {
+                    bits &= olderBitsMask;
+                }
+                else if (step == totalWords.Get())
+                {
+                    bits &= ~olderBitsMask;
+                }
+
+                while (bits != 0)
+                {
+                    if (selected.size() == maxCount)
+                    {
+                        return;
+                    }
+                    selected.push_back(word * 64 + __builtin_ctzll(bits));
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Array(validBits.data(), validBits.size());
+            archive.Array(readyBits.data(), readyBits.size());
+            archive.Array(slotByRobValue.data(), slotByRobValue.size());
+        }
+
+    private:
+        static const unsigned long FixedWords = (FixedRobSize + 63) / 64;
+
+        Capacity<FixedWords> totalWords;
+        CapacityArray<uint64_t, FixedWords> validBits;
+        CapacityArray<uint64_t, FixedWords> readyBits;
+        CapacityArray<int, FixedRobSize> slotByRobValue;
+
+        static uint64_t Bit(int robValue)
+        {
+            return 1ULL << (robValue % 64);
+        }
+};
+
+#endif
@@ -5,49 +5,91 @@
 #include <math.h>
 #include <queue>
 #include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
 #include "sim.h"
 #include "instruction.h"
+#include "instruction_arena.h"
 #include "instructions_table.h"
 #include "rename_map_table.h"
 #include "reorder_buffer.h"
 #include "issue_queue.h"
+#include "wakeup_table.h"
+#include "issue_selector.h"
+#include "scoreboard.h"
+#include "timing_wheel.h"
+#include "stage_profiler.h"
+#include "retire_observer.h"
+#include "trace_source.h"
+#include "stall_statistics.h"
+#include "fixed_capacity.h"
 
 using namespace std;
 
-class Scheduler {
+/// @class SchedulerCore
+/// @brief The out-of-order pipeline. Non-zero template arguments fix WIDTH,
+/// ROB_SIZE and IQ_SIZE at compile time, so the pipeline structures become
+/// std::array-backed and the loops bounded by them can be unrolled. The
+/// constructor arguments must match them. SchedulerCore<> (Scheduler) takes
+/// every size at run time.
+/// Every in-flight instruction lives in the Instructions arena; the latches,
+/// the IQ and the ROB hold indices into it.
+template <unsigned long FixedWidth = 0, unsigned long FixedRobSize = 0, unsigned long FixedIqSize = 0>
+class SchedulerCore {
+    private:
+        // DE and RN each hold up to WIDTH instructions, and every later
+        // stage only holds instructions that are also in the ROB.
+        static const unsigned long FixedArenaSize =
+            FixedWidth != 0 && FixedRobSize != 0 ? FixedRobSize + 2 * FixedWidth : 0;
+
     public:
-        InstructionsTable Decoder;
-        InstructionsTable RenameRegister;
+        InstructionArena<FixedArenaSize> Instructions;
+        InstructionsTable<FixedWidth> Decoder;
+        InstructionsTable<FixedWidth> RenameRegister;
         RenameMapTable RMT;
-        InstructionsTable ReadRegisterTable;
-        InstructionsTable DispatchRegister;
-        InstructionsTable ExecutionList;
-        InstructionsTable WriteBackBuffer;
-        ReorderBuffer ReorderBufferQueue;
-        IssueQueue IssueBuffer;
-        unsigned long &CurrentCyclesCount;
-
-        vector<Instruction> FinalInstructions;
+        InstructionsTable<FixedWidth> ReadRegisterTable;
+        InstructionsTable<FixedWidth> DispatchRegister;
+        TimingWheel ExecutionList;
+        InstructionsTable<FixedWidth * 5> WriteBackBuffer;
+        ReorderBuffer<FixedRobSize> ReorderBufferQueue;
+        IssueQueue<FixedIqSize> IssueBuffer;
+        WakeupTable Wakeup;
+        IssueSelector<FixedRobSize> Selector;
+        /// One bit per ROB value, set when the instruction writes back
+        Scoreboard WrittenBack;
+        uint64_t CurrentCyclesCount = 0;
+        uint64_t FetchedInstructionsCount = 0;
+        uint64_t RetiredInstructionsCount = 0;
+        StallStatistics Statistics;
+        /// Time spent in each stage; empty unless built with -DSIM_PROFILE
+        StageProfiler Profiler;
+
+        /// Notified in program order for every retired instruction
+        vector<RetireObserver*> RetireObservers;
 
     public:
-        Scheduler(FILE* file,
+        SchedulerCore(TraceSource* source,
                 unsigned long width, 
                 unsigned long robSize,
                 unsigned long iqSize,
-                unsigned long &currentCycleCount) : Decoder(width),
+                const std::map<int, int> &opTypeByLatency,
+                unsigned long architecturalRegisterCount = DefaultArchitecturalRegisterCount) : Instructions(robSize + 2 * width),
+                                        Decoder(width),
                                         RenameRegister(width), 
-                                        RMT(), ReadRegisterTable(width), 
-                                        ReorderBufferQueue(robSize), 
+                                        RMT(architecturalRegisterCount), ReadRegisterTable(width), 
                                         DispatchRegister(width),
-                                        IssueBuffer(iqSize),
-                                        ExecutionList(width*5),
+                                        ExecutionList(width, opTypeByLatency),
                                         WriteBackBuffer(width*5),
-                                        CurrentCyclesCount(currentCycleCount)
+                                        ReorderBufferQueue(robSize), 
+                                        IssueBuffer(iqSize),
+                                        Wakeup(robSize),
+                                        Selector(robSize),
+                                        WrittenBack(robSize),
+                                        latencyByOpType(BuildLatencyTable(opTypeByLatency)),
+                                        tableWidth(width)
         {
-            traceFile = file;
-            tableWidth = width;
-            reorderBufferSize = robSize;
-            IqSize = iqSize;
+            traceSource = source;
         }
 
         // Do nothing if either (1) there are no
@@ -62,39 +104,38 @@ class Scheduler {
         // into DE. Fewer than WIDTH instructions
         // will be fetched only if the trace file
         // has fewer than WIDTH instructions left. 
-        void FetchInstruction(unsigned long &fetchedInstructionsCount)
+        void FetchInstruction()
         {
-            uint64_t pc;
-            int op_type, dest, src1, src2;
+            TraceRecord record;
             if (!Decoder.IsEmpty())
             {
+                Statistics.Stall(FetchDecodeBusy);
                 return;
             }
             
-            int currentReadLines = 0;
-            while(fscanf(traceFile, "%lx %d %d %d %d", &pc, &op_type, &dest, &src1, &src2) != EOF)
+            unsigned long currentReadLines = 0;
+            while(currentReadLines < tableWidth.Get() && traceSource->TryGetNext(record))
             {
                 currentReadLines++;
-                Register sourceReg1 = {src1, false, src1 != -1};
-                Register sourceReg2 = {src2, false, src2 != -1};
-                Register destinationReg = {dest, false, dest != -1};
-                Instruction instruction = Instruction(pc, 
-                                                    op_type, 
+                Register sourceReg1 = {record.SourceRegister1, false, record.SourceRegister1 != -1};
+                Register sourceReg2 = {record.SourceRegister2, false, record.SourceRegister2 != -1};
+                Register destinationReg = {record.DestinationRegister, false, record.DestinationRegister != -1};
+                Instruction instruction = Instruction(record.ProgramCounter, 
+                                                    record.OpType, 
                                                     destinationReg, 
                                                     sourceReg1,
                                                     sourceReg2,
-                                                    fetchedInstructionsCount,
+                                                    FetchedInstructionsCount,
                                                     CurrentCyclesCount);
                 
-                instruction.SetEndCycleForRegister(PipelineRegister::FE, CurrentCyclesCount);
-                instruction.SetEndCycleForRegister(PipelineRegister::FE, CurrentCyclesCount - instruction.registerCycles[PipelineRegister::FE].start + 1);
+                instruction.SetEndCycleForRegister(PipelineRegister::FE, CurrentCyclesCount - instruction.GetBeginCycleValueForRegister(PipelineRegister::FE) + 1);
                 instruction.SetBeginCycleForRegister(PipelineRegister::DE, CurrentCyclesCount + 1);
-                Decoder.PushInstruction(instruction);
-                fetchedInstructionsCount++;
-                if (currentReadLines == tableWidth)
-                {
-                    break;
-                }
+                Decoder.PushInstruction(Instructions.Allocate(instruction));
+                FetchedInstructionsCount++;
+            }
+            if (currentReadLines == 0)
+            {
+                Statistics.Stall(FetchNoInstructions);
             }
         }
 
@@ -106,17 +147,23 @@ class Scheduler {
         // from DE to RN.
         void DecodeInstruction()
         {
-            if (Decoder.IsEmpty() || RenameRegister.IsFull())
+            if (Decoder.IsEmpty())
+            {
+                return;
+            }
+            if (RenameRegister.IsFull())
             {
+                Statistics.Stall(DecodeRenameFull);
                 return;
             }
             while(!Decoder.IsEmpty() && !RenameRegister.IsFull())
             {
-                Instruction instruction = Decoder.Front();
-                instruction.SetEndCycleForRegister(PipelineRegister::DE, CurrentCyclesCount - instruction.registerCycles[PipelineRegister::DE].start + 1);
+                int instructionIndex = Decoder.Front();
+                Instruction &instruction = Instructions[instructionIndex];
+                instruction.SetEndCycleForRegister(PipelineRegister::DE, CurrentCyclesCount - instruction.GetBeginCycleValueForRegister(PipelineRegister::DE) + 1);
                 instruction.SetBeginCycleForRegister(PipelineRegister::RN, CurrentCyclesCount+1);
                 
-                RenameRegister.PushInstruction(instruction);
+                RenameRegister.PushInstruction(instructionIndex);
                 Decoder.PopInstruction();
             }
         }
@@ -145,33 +192,44 @@ class Scheduler {
         // the rename bundle are in program order).
         void Rename()
         {
-            if (RenameRegister.IsEmpty()
-                || !ReadRegisterTable.IsEmpty()
-                || ReorderBufferQueue.GetFreeEntries() < RenameRegister.GetSize())
+            if (RenameRegister.IsEmpty())
+            {
+                return;
+            }
+            if (!ReadRegisterTable.IsEmpty())
+            {
+                Statistics.Stall(RenameRegisterReadBusy);
+                return;
+            }
+            if (ReorderBufferQueue.GetFreeEntries() < RenameRegister.GetSize())
             {
+                Statistics.Stall(RenameRobFull);
                 return;
             }
 
             while(!ReorderBufferQueue.IsFull() && !RenameRegister.IsEmpty())
             {
-                Instruction instruction = RenameRegister.Front();
-                int robValue = ReorderBufferQueue.CreateNewEntryAndGetRobValue(instruction);
+                int instructionIndex = RenameRegister.Front();
+                Instruction &instruction = Instructions[instructionIndex];
+                int robValue = ReorderBufferQueue.CreateNewEntryAndGetRobValue(instructionIndex);
                 instruction.RobValue = robValue;
-                CheckIfSourceOperandsHasRMTValues(instruction);
+                WrittenBack.Clear(robValue);
+
+                // The registers keep their architectural names for the
+                // timing output; the renamed operands only feed the wakeup table.
+                Wakeup.AllocateEntry(robValue);
+                Wakeup.AddSourceOperand(robValue, 0, GetRenamedSourceOperand(instruction.SourceRegister1));
+                Wakeup.AddSourceOperand(robValue, 1, GetRenamedSourceOperand(instruction.SourceRegister2));
 
                 if (instruction.DestinationRegister.Exist)
                 {
                     RMT.AddElement(robValue, instruction.DestinationRegister.Value);
                 }
 
-                instruction.DestinationRegister.Value = robValue;
-                instruction.DestinationRegister.Exist = true;
-                instruction.DestinationRegister.HasRobValue = true;
-
-                instruction.SetEndCycleForRegister(PipelineRegister::RN, CurrentCyclesCount+1 - instruction.registerCycles[PipelineRegister::RN].start);
+                instruction.SetEndCycleForRegister(PipelineRegister::RN, CurrentCyclesCount+1 - instruction.GetBeginCycleValueForRegister(PipelineRegister::RN));
                 instruction.SetBeginCycleForRegister(PipelineRegister::RR, CurrentCyclesCount+1);
                 
-                ReadRegisterTable.PushInstruction(instruction);
+                ReadRegisterTable.PushInstruction(instructionIndex);
                 RenameRegister.PopInstruction();
             }
         }
@@ -198,21 +256,24 @@ class Scheduler {
         // (this is required to avoid de
         void ReadRegister()
         {
-            if (ReadRegisterTable.IsEmpty() || DispatchRegister.IsFull())
+            if (ReadRegisterTable.IsEmpty())
+            {
+                return;
+            }
+            if (DispatchRegister.IsFull())
             {
+                Statistics.Stall(RegisterReadDispatchFull);
                 return;
             }
 
             while(!ReadRegisterTable.IsEmpty() && !DispatchRegister.IsFull())
             {
-                Instruction instruction  = ReadRegisterTable.Front();
-                instruction.SourceRegister1.IsReady = IsRegisterReady(instruction.SourceRegister1);
-                instruction.SourceRegister2.IsReady = IsRegisterReady(instruction.SourceRegister2);
-
-                instruction.SetEndCycleForRegister(PipelineRegister::RR, CurrentCyclesCount+1 - instruction.registerCycles[PipelineRegister::RR].start);
+                int instructionIndex = ReadRegisterTable.Front();
+                Instruction &instruction = Instructions[instructionIndex];
+                instruction.SetEndCycleForRegister(PipelineRegister::RR, CurrentCyclesCount+1 - instruction.GetBeginCycleValueForRegister(PipelineRegister::RR));
                 instruction.SetBeginCycleForRegister(PipelineRegister::DI, CurrentCyclesCount+1);
 
-                DispatchRegister.PushInstruction(instruction);
+                DispatchRegister.PushInstruction(instructionIndex);
                 ReadRegisterTable.PopInstruction();
             }
         }
@@ -227,23 +288,25 @@ class Scheduler {
         // the IQ.
         void DispatchInstruction()
         {
-            if (DispatchRegister.IsEmpty() 
-                || IssueBuffer.GetFreeIssueQueueEntries() < DispatchRegister.GetSize())
+            if (DispatchRegister.IsEmpty())
             {
                 return;
             }
-            for (int i = 0; i < IssueBuffer.size; i++)
+            if (IssueBuffer.GetFreeIssueQueueEntries() < DispatchRegister.GetSize())
             {
-                if (IssueBuffer.issueQueue[i].InstructionValidInIQ == false && !DispatchRegister.IsEmpty())
-                {
-                    Instruction instruction = DispatchRegister.Front();
-                    instruction.SetEndCycleForRegister(PipelineRegister::DI, CurrentCyclesCount+1 - instruction.registerCycles[PipelineRegister::DI].start);
-                    instruction.SetBeginCycleForRegister(PipelineRegister::IS, CurrentCyclesCount+1);
-
-                    instruction.InstructionValidInIQ = true;
-                    IssueBuffer.issueQueue[i] = instruction;
-                    DispatchRegister.PopInstruction();
-                }
+                Statistics.Stall(DispatchIqFull);
+                return;
+            }
+            while (!DispatchRegister.IsEmpty())
+            {
+                int instructionIndex = DispatchRegister.Front();
+                Instruction &instruction = Instructions[instructionIndex];
+                instruction.SetEndCycleForRegister(PipelineRegister::DI, CurrentCyclesCount+1 - instruction.GetBeginCycleValueForRegister(PipelineRegister::DI));
+                instruction.SetBeginCycleForRegister(PipelineRegister::IS, CurrentCyclesCount+1);
+
+                int slot = IssueBuffer.AddElement(instructionIndex);
+                Selector.Insert(instruction.RobValue, slot, Wakeup.IsInstructionReady(instruction.RobValue));
+                DispatchRegister.PopInstruction();
             }
         }
         
@@ -264,42 +327,30 @@ class Scheduler {
         // instruction in the execute_list that
         // will allow you to model its execution
         // latency.
-        void IssueInstruction(std::map<int, int> opTypeByLatency)
+        void IssueInstruction()
         {
             if (IssueBuffer.IsEmpty())
             {
                 return;
             }
 
-            int issuedInstructions = 0;
-            sort(IssueBuffer.issueQueue, IssueBuffer.issueQueue + IqSize, [this](const Instruction& a, const Instruction& b) 
+            Selector.SelectOldest(ReorderBufferQueue.headIndex, tableWidth.Get(), selectedRobValues);
+            if (selectedRobValues.empty())
             {
-            return compareInstructions(a, b);
-            });
-
-            for (int i = 0; i < IqSize; i++)
+                Statistics.Stall(IssueOperandsNotReady);
+            }
+            for (int robValue : selectedRobValues)
             {
-                if (issuedInstructions >= tableWidth)
-                {
-                    break;
-                }
-                
-                if (IssueBuffer.issueQueue[i].InstructionSequenceNumber < 0 
-                    || !IssueBuffer.issueQueue[i].InstructionValidInIQ 
-                    || !IssueBuffer.issueQueue[i].SourceRegister1.IsReady
-                    || !IssueBuffer.issueQueue[i].SourceRegister2.IsReady)
-                {
-                    continue;
-                }
-
-                Instruction instruction = IssueBuffer.issueQueue[i];
+                int i = Selector.GetSlot(robValue);
+                int instructionIndex = IssueBuffer.issueQueue[i];
+                Instruction &instruction = Instructions[instructionIndex];
                 IssueBuffer.RemoveElementAtIndex(i);
+                Selector.Remove(robValue);
 
-                instruction.SetEndCycleForRegister(PipelineRegister::IS, CurrentCyclesCount+1 - instruction.registerCycles[PipelineRegister::IS].start);
+                instruction.SetEndCycleForRegister(PipelineRegister::IS, CurrentCyclesCount+1 - instruction.GetBeginCycleValueForRegister(PipelineRegister::IS));
                 instruction.SetBeginCycleForRegister(PipelineRegister::EX, CurrentCyclesCount+1);
-                instruction.Latency = opTypeByLatency[instruction.OpType];
-                ExecutionList.PushInstruction(instruction);
-                issuedInstructions++;
+                instruction.Latency = GetLatency(instruction.OpType);
+                ExecutionList.Insert(instructionIndex, CurrentCyclesCount + instruction.Latency);
             }
         }
 
@@ -315,29 +366,20 @@ class Scheduler {
         // RR (the register-read bundle).
         void Execute()
         {
-            InstructionsTable tempTable = InstructionsTable(tableWidth*5);
-            while (!ExecutionList.IsEmpty())
+            // Only the instructions finishing this cycle are touched.
+            ExecutionList.DrainCompleted(CurrentCyclesCount, [this](int instructionIndex)
             {
-                Instruction instruction = ExecutionList.Front();
-                if (ExecutionList.Front().Latency == 1)
+                Instruction &instruction = Instructions[instructionIndex];
+                Wakeup.Wakeup(instruction.RobValue, [this](int robValue)
                 {
-                    ReadRegisterTable.CheckAndWakeupSourceOperandsInInstructions(instruction.RobValue);
-                    DispatchRegister.CheckAndWakeupSourceOperandsInInstructions(instruction.RobValue);
-                    IssueBuffer.CheckAndWakeupSourceOperandsInInstructions(instruction.RobValue);
-
-                    instruction.SetEndCycleForRegister(PipelineRegister::EX, 
-                                CurrentCyclesCount+1 - instruction.registerCycles[PipelineRegister::EX].start);
-                    instruction.SetBeginCycleForRegister(PipelineRegister::WB, CurrentCyclesCount+1);
-                    WriteBackBuffer.PushInstruction(instruction);
-                }
-                else
-                {
-                    instruction.Latency--;
-                    tempTable.PushInstruction(instruction);
-                }
-                ExecutionList.PopInstruction();
-            }
-            ExecutionList = tempTable;
+                    Selector.MarkReady(robValue);
+                });
+
+                instruction.SetEndCycleForRegister(PipelineRegister::EX, 
+                            CurrentCyclesCount+1 - instruction.GetBeginCycleValueForRegister(PipelineRegister::EX));
+                instruction.SetBeginCycleForRegister(PipelineRegister::WB, CurrentCyclesCount+1);
+                WriteBackBuffer.PushInstruction(instructionIndex);
+            });
         }
 
         // From the execute_list, check for
@@ -358,12 +400,11 @@ class Scheduler {
             }
             while(!WriteBackBuffer.IsEmpty())
             {
-                Instruction instruction = WriteBackBuffer.Front();
+                Instruction &instruction = Instructions[WriteBackBuffer.Front()];
                 instruction.SetEndCycleForRegister(PipelineRegister::WB, 
-                                CurrentCyclesCount+1 - instruction.registerCycles[PipelineRegister::WB].start);
+                                CurrentCyclesCount+1 - instruction.GetBeginCycleValueForRegister(PipelineRegister::WB));
                 instruction.SetBeginCycleForRegister(PipelineRegister::RT, CurrentCyclesCount+1);
-                ReorderBufferQueue.UpdateReadinessOfTheInstruction(instruction.DestinationRegister.Value, 
-                    instruction.registerCycles);
+                WrittenBack.Set(instruction.RobValue);
                 WriteBackBuffer.PopInstruction();
             }
         }
@@ -373,21 +414,31 @@ class Scheduler {
         // the ROB.
         void RetireInstructions()
         {
-            if (ReorderBufferQueue.IsEmpty() 
-                || !ReorderBufferQueue.Front().DestinationRegister.IsReady)
+            if (ReorderBufferQueue.IsEmpty())
             {
+                Statistics.Stall(RetireRobEmpty);
+                return;
+            }
+            if (!IsRobHeadReady())
+            {
+                Statistics.Stall(RetireHeadNotReady);
                 return;
             }
 
-            int poppedInstructions = 0;
-            while(!ReorderBufferQueue.IsEmpty() 
-                && ReorderBufferQueue.Front().DestinationRegister.IsReady
-                && poppedInstructions < tableWidth)
+            // The ROB holds consecutive ROB values, so one scan of the
+            // scoreboard finds the whole retire bundle.
+            unsigned long readyInstructions = WrittenBack.CountReadyFrom(ReorderBufferQueue.headIndex,
+                                        min(tableWidth.Get(), ReorderBufferQueue.GetSize()));
+            for (unsigned long i = 0; i < readyInstructions; i++)
             {
-                Instruction instruction = ReorderBufferQueue.Front();
+                int instructionIndex = ReorderBufferQueue.Front();
+                Instruction &instruction = Instructions[instructionIndex];
                 instruction.SetEndCycleForRegister(PipelineRegister::RT, 
-                                CurrentCyclesCount+1 - instruction.registerCycles[PipelineRegister::RT].start);
-                FinalInstructions.push_back(instruction);
+                                CurrentCyclesCount+1 - instruction.GetBeginCycleValueForRegister(PipelineRegister::RT));
+                for (auto observer : RetireObservers)
+                {
+                    observer->OnRetire(instruction);
+                }
 
                 RenameMapElement mapElement;
                 if (RMT.TryGetElement(instruction.DestinationRegister.Value, mapElement)
@@ -396,13 +447,141 @@ class Scheduler {
                     RMT.RemoveElementAtIndex(instruction.DestinationRegister.Value);
                 }
                 ReorderBufferQueue.PopInstruction();
-                poppedInstructions++;
+                Instructions.Release(instructionIndex);
+                RetiredInstructionsCount++;
+            }
+        }
+
+        // Simulates one cycle. The stages run in
+        // reverse pipeline order so that every
+        // stage sees the state its successor left
+        // at the end of the previous cycle.
+        //
+        // Each stage is bracketed by the profiler,
+        // which compiles to nothing unless it is
+        // built in. The items each stage moved come
+        // from the latch sizes around it.
+        void RunCycle()
+        {
+            uint64_t retiredBefore = RetiredInstructionsCount;
+            Profiler.Begin();
+            RetireInstructions();
+            Profiler.End(ProfileRetire, RetiredInstructionsCount - retiredBefore);
+
+            unsigned long writtenBack = WriteBackBuffer.GetSize();
+            Profiler.Begin();
+            WritebackToRegister();
+            Profiler.End(ProfileWriteback, writtenBack);
+
+            Profiler.Begin();
+            Execute();
+            Profiler.End(ProfileExecute, WriteBackBuffer.GetSize());
+
+            unsigned long executing = ExecutionList.GetSize();
+            Profiler.Begin();
+            IssueInstruction();
+            Profiler.End(ProfileIssue, ExecutionList.GetSize() - executing);
+
+            unsigned long dispatchBundle = DispatchRegister.GetSize();
+            Profiler.Begin();
+            DispatchInstruction();
+            Profiler.End(ProfileDispatch, dispatchBundle - DispatchRegister.GetSize());
+
+            unsigned long registerReadBundle = ReadRegisterTable.GetSize();
+            Profiler.Begin();
+            ReadRegister();
+            Profiler.End(ProfileRegisterRead, registerReadBundle - ReadRegisterTable.GetSize());
+
+            unsigned long renameBundle = RenameRegister.GetSize();
+            Profiler.Begin();
+            Rename();
+            Profiler.End(ProfileRename, renameBundle - RenameRegister.GetSize());
+
+            unsigned long decodeBundle = Decoder.GetSize();
+            Profiler.Begin();
+            DecodeInstruction();
+            Profiler.End(ProfileDecode, decodeBundle - Decoder.GetSize());
+
+            uint64_t fetchedBefore = FetchedInstructionsCount;
+            Profiler.Begin();
+            FetchInstruction();
+            Profiler.End(ProfileFetch, FetchedInstructionsCount - fetchedBefore);
+            CurrentCyclesCount++;
+            EndStatisticsCycles(1, RetiredInstructionsCount - retiredBefore);
+        }
+
+        // Accounts for an instruction that is not
+        // simulated in detail, as in sampled
+        // simulation. It must only be called with
+        // an empty pipeline: the instruction is
+        // treated as already retired, so its
+        // destination maps to the architectural
+        // register file again.
+        void FunctionallyWarm(const TraceRecord &record)
+        {
+            if (record.DestinationRegister != -1)
+            {
+                RMT.RemoveElementAtIndex(record.DestinationRegister);
             }
+            FetchedInstructionsCount++;
+        }
+
+        // Skips cycles in which the only activity
+        // would be instructions counting down their
+        // execution latency. Every other stage is
+        // blocked on state that only changes when
+        // an instruction finishes execution, so
+        // jumping to the cycle the next timing
+        // wheel bucket completes in gives the
+        // same timings as simulating each cycle.
+        // Returns the number of skipped cycles.
+        uint64_t FastForwardIdleCycles()
+        {
+            Profiler.Begin();
+            uint64_t idleCycles = SkipIdleCycles();
+            Profiler.End(ProfileFastForward, idleCycles);
+            return idleCycles;
+        }
+
+        /// @brief Gets the execution latency of each op type, indexed by op type.
+        const vector<int> &GetLatencyTable()
+        {
+            return latencyByOpType;
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        /// The trace position is FetchedInstructionsCount records into the trace.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Value(CurrentCyclesCount);
+            archive.Value(FetchedInstructionsCount);
+            archive.Value(RetiredInstructionsCount);
+            Instructions.Transfer(archive);
+            Decoder.Transfer(archive);
+            RenameRegister.Transfer(archive);
+            RMT.Transfer(archive);
+            ReadRegisterTable.Transfer(archive);
+            DispatchRegister.Transfer(archive);
+            ExecutionList.Transfer(archive);
+            WriteBackBuffer.Transfer(archive);
+            ReorderBufferQueue.Transfer(archive);
+            IssueBuffer.Transfer(archive);
+            Wakeup.Transfer(archive);
+            Selector.Transfer(archive);
+            WrittenBack.Transfer(archive);
+            Statistics.Transfer(archive);
         }
 
+        // Keep simulating until the trace reader has handed out every
+        // instruction and all of them have left the pipeline. Instructions
+        // from RR onwards are always in the ROB.
         bool AdvanceToNextCycle()
         {
-            if (feof(traceFile) && ReorderBufferQueue.IsEmpty()) 
+            if (traceSource->IsExhausted()
+                && Decoder.IsEmpty()
+                && RenameRegister.IsEmpty()
+                && ReorderBufferQueue.IsEmpty()) 
             {
                 return false;
             }
@@ -410,54 +589,103 @@ class Scheduler {
         }
 
     private:
-        FILE* traceFile;
-        unsigned long tableWidth = 0;
-        unsigned long reorderBufferSize = 0;
-        unsigned long IqSize = 0; 
+        // Op types without a configured latency execute in one cycle, as
+        // do configured latencies below one cycle.
+        static constexpr int DefaultLatency = 1;
 
-        void CheckIfSourceOperandsHasRMTValues(Instruction& instruction)
-        {
-            RenameMapElement sourceRegister1, sourceRegister2;
-            Register sourceReg1, sourceReg2;
+        TraceSource* traceSource;
+        /// Execution latency indexed by op type, at least one cycle
+        vector<int> latencyByOpType;
+        Capacity<FixedWidth> tableWidth;
+        vector<int> selectedRobValues;
 
-            if (instruction.SourceRegister1.Exist && RMT.TryGetElement(instruction.SourceRegister1.Value, sourceRegister1))
-            {
-                sourceReg1 = {sourceRegister1.RobValue, true, true};
-                instruction.SourceRegister1 = sourceReg1;
-            }
-            if (instruction.SourceRegister2.Exist && RMT.TryGetElement(instruction.SourceRegister2.Value, sourceRegister2)) 
+        static vector<int> BuildLatencyTable(const std::map<int, int> &opTypeByLatency)
+        {
+            vector<int> latencies;
+            for (auto &opTypeLatency : opTypeByLatency)
             {
-                sourceReg2= {sourceRegister2.RobValue, true, true};
-                instruction.SourceRegister2 = sourceReg2;
+                if (opTypeLatency.first < 0)
+                {
+                    continue;
+                }
+                if ((size_t)opTypeLatency.first >= latencies.size())
+                {
+                    latencies.resize(opTypeLatency.first + 1, DefaultLatency);
+                }
+                latencies[opTypeLatency.first] = max(opTypeLatency.second, DefaultLatency);
             }
+            return latencies;
         }
 
-        bool IsRegisterReady(Register registerVal)
+        int GetLatency(int opType)
         {
-            if (registerVal.HasRobValue 
-                && ReorderBufferQueue.IsRobEntryReady(registerVal.Value)
-                || !registerVal.Exist
-                || registerVal.IsReady)
-            {
-                return true;
-            }
-            else if (!registerVal.HasRobValue && registerVal.Value != -1)
+            return (unsigned)opType < latencyByOpType.size() ? latencyByOpType[opType] : DefaultLatency;
+        }
+
+        void EndStatisticsCycles(uint64_t cycles, uint64_t retired)
+        {
+            Statistics.EndCycles(cycles, retired, tableWidth.Get(), ReorderBufferQueue.GetSize(), Selector.GetSize());
+        }
+
+        // The body of FastForwardIdleCycles, kept
+        // apart so the profiler can time it as a whole.
+        uint64_t SkipIdleCycles()
+        {
+            if (ExecutionList.IsEmpty()
+                || !WriteBackBuffer.IsEmpty()
+                || (!ReorderBufferQueue.IsEmpty() && IsRobHeadReady())
+                || Selector.HasReadyInstruction()
+                || (!DispatchRegister.IsEmpty() && IssueBuffer.GetFreeIssueQueueEntries() >= DispatchRegister.GetSize())
+                || (!ReadRegisterTable.IsEmpty() && !DispatchRegister.IsFull())
+                || (!RenameRegister.IsEmpty() && ReadRegisterTable.IsEmpty() && ReorderBufferQueue.GetFreeEntries() >= RenameRegister.GetSize())
+                || (!Decoder.IsEmpty() && !RenameRegister.IsFull())
+                || (Decoder.IsEmpty() && !traceSource->IsExhausted()))
             {
-                return true;
+                return 0;
             }
-            else if (registerVal.HasRobValue && !ReorderBufferQueue.HasRobEntry(registerVal.Value))
+
+            uint64_t nextCompletionCycle = CurrentCyclesCount;
+            ExecutionList.TryGetNextCompletion(CurrentCyclesCount, nextCompletionCycle);
+            uint64_t idleCycles = nextCompletionCycle - CurrentCyclesCount;
+            if (idleCycles == 0)
             {
-                return true;
+                return 0;
             }
-            return false;
+            CurrentCyclesCount += idleCycles;
+
+            // Every stage is blocked in the skipped cycles and would take
+            // the same early return each time. Replaying the stages that
+            // leave the execution latencies alone records those stalls.
+            RetireInstructions();
+            IssueInstruction();
+            DispatchInstruction();
+            ReadRegister();
+            Rename();
+            DecodeInstruction();
+            FetchInstruction();
+            EndStatisticsCycles(idleCycles, 0);
+            return idleCycles;
         }
 
-        bool compareInstructions(const Instruction& a, const Instruction& b) 
+        bool IsRobHeadReady()
         {
-            return a.InstructionSequenceNumber>=0 
-                && b.InstructionSequenceNumber >= 0 
-                && a.InstructionSequenceNumber < b.InstructionSequenceNumber;
+            return WrittenBack.Test(ReorderBufferQueue.headIndex);
+        }
+
+        // Gets the source operand renamed to the ROB value of its
+        // producer if the producer is still in flight.
+        Register GetRenamedSourceOperand(const Register &sourceRegister)
+        {
+            RenameMapElement mapElement;
+            if (sourceRegister.Exist && RMT.TryGetElement(sourceRegister.Value, mapElement))
+            {
+                return {mapElement.RobValue, true, true};
+            }
+            return sourceRegister;
         }
 };
 
+/// The scheduler with every size chosen at run time.
+typedef SchedulerCore<> Scheduler;
+
 #endif  // End of include guard
\ No newline at end of file
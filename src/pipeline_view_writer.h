@@ -0,0 +1,172 @@
+#ifndef PIPELINE_VIEW_WRITER_H   // Include guard to prevent multiple inclusions
+#define PIPELINE_VIEW_WRITER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <limits>
+#include <string>
+#include <vector>
+#include "sim.h"
+#include "instruction.h"
+#include "retire_observer.h"
+
+using namespace std;
+
+/// Names of the pipeline stages, indexed by PipelineRegister.
+const char *const PipelineRegisterNames[TotalPipelineRegisters] = {
+    "FE", "DE", "RN", "RR", "DI", "IS", "EX", "WB", "RT"};
+
+/// @brief Parses an inclusive "FIRST:LAST" range of sequence numbers.
+/// @param text Range to parse. Either bound may be left out.
+/// @param first [out] First sequence number to keep.
+/// @param last [out] Last sequence number to keep.
+inline bool ParseSequenceRange(const string &text, uint64_t &first, uint64_t &last)
+{
+    size_t colon = text.find(':');
+    if (colon == string::npos)
+    {
+        return false;
+    }
+    string firstText = text.substr(0, colon);
+    string lastText = text.substr(colon + 1);
+    char *end;
+    first = 0;
+    last = std::numeric_limits<uint64_t>::max();
+    if (!firstText.empty())
+    {
+        first = strtoull(firstText.c_str(), &end, 10);
+        if (*end != '\0')
+        {
+            return false;
+        }
+    }
+    if (!lastText.empty())
+    {
+        last = strtoull(lastText.c_str(), &end, 10);
+        if (*end != '\0')
+        {
+            return false;
+        }
+    }
+    return first <= last;
+}
+
+/// @class PipelineViewWriter
+/// @brief Streams retired instructions as Chrome trace-event JSON.
+/// Every instruction gets its own row, labelled like a timing line, with one
+/// complete event per pipeline stage; one cycle is shown as one microsecond.
+/// The file opens in chrome://tracing or ui.perfetto.dev. Events are written
+/// through a fixed-size buffer as instructions retire, and only instructions
+/// inside the sequence range are exported.
+class PipelineViewWriter : public RetireObserver
+{
+    public:
+        PipelineViewWriter(size_t bufferSize = 1 << 16) : buffer(bufferSize + MaxEventsLength)
+        {
+            flushThreshold = bufferSize;
+        }
+
+        ~PipelineViewWriter()
+        {
+            Close();
+        }
+
+        PipelineViewWriter(const PipelineViewWriter&) = delete;
+        PipelineViewWriter& operator=(const PipelineViewWriter&) = delete;
+
+        /// @brief Creates the output file and writes the JSON prologue.
+        /// @param fileName Path of the trace-event file.
+        /// @param first First sequence number to export.
+        /// @param last Last sequence number to export.
+        bool Open(const char *fileName, uint64_t first = 0, uint64_t last = std::numeric_limits<uint64_t>::max())
+        {
+            outputFile = fopen(fileName, "w");
+            if (outputFile == NULL)
+            {
+                return false;
+            }
+            firstSequenceNumber = first;
+            lastSequenceNumber = last;
+            fputs("{\"traceEvents\":[\n", outputFile);
+            return true;
+        }
+
+        /// @brief Formats the stage events of the retired instruction.
+        /// @param instruction The retired instruction.
+        void OnRetire(const Instruction &instruction) override
+        {
+            uint64_t sequenceNumber = instruction.InstructionSequenceNumber;
+            if (outputFile == NULL || sequenceNumber < firstSequenceNumber || sequenceNumber > lastSequenceNumber)
+            {
+                return;
+            }
+
+            char *out = &buffer[usedBytes];
+            char *end = out + MaxEventsLength;
+            out += snprintf(out, end - out,
+                "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%" PRIu64 ","
+                "\"args\":{\"name\":\"%" PRIu64 " fu{%d} src{%d,%d} dst{%d}\"}}",
+                eventsWritten ? ",\n" : "", sequenceNumber, sequenceNumber, instruction.OpType,
+                instruction.SourceRegister1.Value, instruction.SourceRegister2.Value,
+                instruction.DestinationRegister.Value);
+            for (int stage = 0; stage < TotalPipelineRegisters; stage++)
+            {
+                PipelineRegister pipelineRegister = (PipelineRegister)stage;
+                out += snprintf(out, end - out,
+                    ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":0,\"tid\":%" PRIu64 ",\"ts\":%" PRId64 ",\"dur\":%d}",
+                    PipelineRegisterNames[stage], sequenceNumber,
+                    instruction.GetBeginCycleValueForRegister(pipelineRegister),
+                    instruction.GetEndCycleValueForRegister(pipelineRegister));
+            }
+            eventsWritten = true;
+            usedBytes = out - buffer.data();
+            if (usedBytes >= flushThreshold)
+            {
+                Flush();
+            }
+        }
+
+        /// @brief Writes the buffered events to the file.
+        void Flush()
+        {
+            if (outputFile == NULL)
+            {
+                return;
+            }
+            fwrite(buffer.data(), 1, usedBytes, outputFile);
+            fflush(outputFile);
+            usedBytes = 0;
+        }
+
+        /// @brief Writes the buffered events and the JSON epilogue, and closes the file.
+        /// @return `false` if any write failed.
+        bool Close()
+        {
+            if (outputFile == NULL)
+            {
+                return true;
+            }
+            Flush();
+            fputs("\n]}\n", outputFile);
+            bool written = !ferror(outputFile);
+            written = fclose(outputFile) == 0 && written;
+            outputFile = NULL;
+            return written;
+        }
+
+    private:
+        /// Upper bound on the length of the events of one instruction.
+        static const size_t MaxEventsLength = 2048;
+
+        FILE *outputFile = NULL;
+        vector<char> buffer;
+        size_t usedBytes = 0;
+        size_t flushThreshold;
+        uint64_t firstSequenceNumber = 0;
+        uint64_t lastSequenceNumber = std::numeric_limits<uint64_t>::max();
+        bool eventsWritten = false;
+
+};
+
+#endif
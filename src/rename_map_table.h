@@ -1,79 +1,104 @@
 #ifndef RENAME_MAP_TABLE_H   // Include guard to prevent multiple inclusions
 #define RENAME_MAP_TABLE_H
 
-#include <queue>
-#include <string>
+#include <inttypes.h>
+#include <vector>
+#include "sim.h"
 
 using namespace std;
 
+/// Architectural registers of the traces the simulator was written for.
+const unsigned long DefaultArchitecturalRegisterCount = 67;
+
 /// @class RenameMapTable
-/// @brief Class that contains an array of RMT elements by rob values and register indices.
+/// @brief Class that maps architectural registers to the ROB values of their latest producers.
+/// The table is indexed directly by register number, with a bitset marking
+/// the registers that currently have a producer in flight.
 class RenameMapTable
 {
     public:
-        RenameMapElement* renameMapTable;
-
-        RenameMapTable()
+        RenameMapTable(unsigned long registerCount = DefaultArchitecturalRegisterCount)
+            : robValueByRegister(registerCount, -1),
+              validBits((registerCount + 63) / 64, 0)
         {
-            renameMapTable = new RenameMapElement[size];
-            for (int i = 0; i < size; ++i)
-            {
-                renameMapTable[i].Valid = false;
-            }
         }
-        
+
         /// @brief Adds or Updates a new element to the Rename Map table
-        /// @param robIndex Reorder buffer value.
+        /// @param robValue Reorder buffer value.
         /// @param registerIndex Register index/value.
         void AddElement(int robValue, int registerIndex)
         {
-            renameMapTable[registerIndex].RegisterIndex = registerIndex;
-            renameMapTable[registerIndex].RobValue = robValue;
-            renameMapTable[registerIndex].Valid = true;
+            if (!IsInRange(registerIndex))
+            {
+                outOfRangeRegister = true;
+                return;
+            }
+            robValueByRegister[registerIndex] = robValue;
+            validBits[registerIndex / 64] |= Bit(registerIndex);
         }
-        
+
         /// @brief Removes element at register index.
         /// @param registerIndex Register index/value.
         void RemoveElementAtIndex(int registerIndex)
         {
-            renameMapTable[registerIndex].Valid = false;
-        }
-        
-        /// @brief Gets whether the rename map table is empty or not based on the validity.
-        bool IsEmpty()
-        {
-            for (int i = 0; i < size; i++)
+            if (IsInRange(registerIndex))
             {
-                if (renameMapTable[i].Valid)
-                {
-                    return false;
-                }
+                validBits[registerIndex / 64] &= ~Bit(registerIndex);
             }
-            return true;
         }
 
         /// @brief Attempts to get the element from the RMT.
+        /// @param registerIndex Register index/value.
         /// @param renameMapElement [out] Reference to an RMT element where the value will be stored if available.
         /// @return `true` if the element has a valid ROB value, `false` otherwise.
         bool TryGetElement(int registerIndex, RenameMapElement &renameMapElement)
         {
-            if(IsEmpty())
+            if (!IsInRange(registerIndex) || (validBits[registerIndex / 64] & Bit(registerIndex)) == 0)
             {
                 return false;
             }
-            for (int i = 0; i < size; i++)
-            {
-                if (renameMapTable[i].Valid && renameMapTable[i].RegisterIndex == registerIndex)
-                {
-                    renameMapElement = renameMapTable[registerIndex];
-                    return true;
-                }
-            }
-            return false;
+            renameMapElement.RegisterIndex = registerIndex;
+            renameMapElement.RobValue = robValueByRegister[registerIndex];
+            renameMapElement.Valid = true;
+            return true;
         }
-    
+
+        /// @brief Gets the number of architectural registers.
+        unsigned long GetRegisterCount()
+        {
+            return robValueByRegister.size();
+        }
+
+        /// @brief Gets whether a destination register beyond the register count was
+        /// seen. Such registers are never renamed, so their consumers do not wait.
+        bool HasOutOfRangeRegister()
+        {
+            return outOfRangeRegister;
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Vector(robValueByRegister);
+            archive.Vector(validBits);
+            archive.Value(outOfRangeRegister);
+        }
+
     private:
-        unsigned long size = 67;
+        vector<int> robValueByRegister;
+        vector<uint64_t> validBits;
+        bool outOfRangeRegister = false;
+
+        bool IsInRange(int registerIndex)
+        {
+            return registerIndex >= 0 && (unsigned long)registerIndex < robValueByRegister.size();
+        }
+
+        static uint64_t Bit(int registerIndex)
+        {
+            return 1ULL << (registerIndex % 64);
+        }
 };
 
-#endif
\ No newline at end of file
+#endif
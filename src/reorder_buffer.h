@@ -1,91 +1,98 @@
 #ifndef REORDER_BUFFER_H   // Include guard to prevent multiple inclusions
 #define REORDER_BUFFER_H
 
-#include <queue>
-#include <math.h>
-#include "instructions_table.h"
+#include "fixed_capacity.h"
 
 using namespace std;
 
 /// @class ReorderBuffer
-/// @brief The class that implements ROB queue
-class ReorderBuffer : public InstructionsTable
+/// @brief The class that implements the ROB as a fixed-capacity circular array.
+/// The ROB value (tag) of an instruction is the index of its slot, so lookups
+/// by ROB value never have to walk the buffer. Each slot holds the
+/// InstructionArena index of its instruction. A non-zero FixedSize fixes
+/// the capacity at compile time.
+template <unsigned long FixedSize = 0>
+class ReorderBuffer
 {
     public:
-        int tailIndex = -1;
-        int lastRemovedElementIndex;
-        unsigned long queueSize;
-        
-        ReorderBuffer(unsigned long queue_size) : InstructionsTable (queue_size) 
+        CapacityArray<int, FixedSize> reorderBuffer;
+        unsigned long headIndex = 0;
+        unsigned long tailIndex = 0;
+        unsigned long count = 0;
+
+        ReorderBuffer(unsigned long queue_size) : reorderBuffer(queue_size), queueSize(queue_size)
         {
-            queueSize = queue_size;
         }
-        
+
         /// @brief Creates a new entry in the ROB and returns the ROB index value.
-        /// @param instruction The instruction in which a new entry is to be created.
-        int CreateNewEntryAndGetRobValue(Instruction instruction)
+        /// @param instructionIndex Arena index of the instruction in which a new entry is to be created.
+        int CreateNewEntryAndGetRobValue(int instructionIndex)
         {
-            if (tailIndex >= queueSize)
+            int robValue = tailIndex;
+            reorderBuffer[tailIndex] = instructionIndex;
+
+            tailIndex++;
+            if (tailIndex == queueSize.Get())
             {
-                tailIndex = -1;
+                tailIndex = 0;
             }
-            tailIndex++;
-            instruction.RobValue = tailIndex;
-            InstructionsQueue.push(instruction);
-            return instruction.RobValue;
+            count++;
+            return robValue;
         }
 
-        /// @brief Gets whether the rob entry is ready or not.
-        /// @param robValue Rob value.
-        bool IsRobEntryReady(int robValue)
+        /// @brief Removes instruction at the head of the ROB.
+        void PopInstruction()
         {
-            queue<Instruction> instructions = InstructionsQueue;
-            while(!instructions.empty())
+            headIndex++;
+            if (headIndex == queueSize.Get())
             {
-                if(instructions.front().RobValue == robValue 
-                && instructions.front().DestinationRegister.IsReady)
-                {
-                    return true;
-                }
-                instructions.pop();
+                headIndex = 0;
             }
-            return false;
+            count--;
         }
 
-        /// @brief Sets the source registers as ready based on the rob value.
-        /// @param robValue Rob value.
-        /// @param registerCycles Register cycles of each pipeline stages.
-        void UpdateReadinessOfTheInstruction(int robValue, std::map<PipelineRegister, CycleInfo> registerCycles)
+        /// @brief Gets the arena index of the head instruction of the ROB.
+        int Front()
         {
-            std::queue<Instruction> tempQueue;
-            while (!InstructionsQueue.empty()) 
-            {
-                if (InstructionsQueue.front().RobValue == robValue) 
-                {
-                    InstructionsQueue.front().DestinationRegister.IsReady = true;
-                    InstructionsQueue.front().registerCycles = registerCycles;
-                }
-                tempQueue.push(InstructionsQueue.front());
-                InstructionsQueue.pop();
-            }
-            InstructionsQueue = tempQueue;
+            return reorderBuffer[headIndex];
         }
 
-        /// @brief Gets whether the rob entry is present or not.
-        /// @param robValue Rob value.
-        bool HasRobEntry(int robValue)
+        /// @brief Gets the number of occupied ROB entries.
+        unsigned long GetSize()
         {
-            std::queue<Instruction> tempQueue = InstructionsQueue;
-            while (!tempQueue.empty()) 
-            {
-                if (tempQueue.front().RobValue == robValue) 
-                {
-                    return true;
-                }
-                tempQueue.pop();
-            }
-            return false;
+            return count;
+        }
+
+        /// @brief Gets whether the ROB is empty or not.
+        bool IsEmpty()
+        {
+            return count == 0;
+        }
+
+        /// @brief Gets whether the ROB is full or not.
+        bool IsFull()
+        {
+            return count == queueSize.Get();
         }
+
+        /// @brief Gets the free entries of the ROB.
+        unsigned long GetFreeEntries()
+        {
+            return queueSize.Get() - count;
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Array(reorderBuffer.data(), reorderBuffer.size());
+            archive.Value(headIndex);
+            archive.Value(tailIndex);
+            archive.Value(count);
+        }
+
+    private:
+        Capacity<FixedSize> queueSize;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,20 @@
+#ifndef RETIRE_OBSERVER_H   // Include guard to prevent multiple inclusions
+#define RETIRE_OBSERVER_H
+
+#include "instruction.h"
+
+/// @class RetireObserver
+/// @brief Interface notified by the scheduler for every retired instruction.
+/// Instructions retire in program order, so observers see them sorted by
+/// sequence number.
+class RetireObserver
+{
+    public:
+        virtual ~RetireObserver() {}
+
+        /// @brief Called when an instruction retires from the head of the ROB.
+        /// @param instruction The retired instruction with its final stage timings.
+        virtual void OnRetire(const Instruction &instruction) = 0;
+};
+
+#endif
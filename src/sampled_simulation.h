@@ -0,0 +1,236 @@
+#ifndef SAMPLED_SIMULATION_H   // Include guard to prevent multiple inclusions
+#define SAMPLED_SIMULATION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <math.h>
+#include <map>
+#include <vector>
+#include "sim.h"
+#include "instruction.h"
+#include "retire_observer.h"
+#include "trace_source.h"
+#include "out_of_order_scheduler.h"
+
+using namespace std;
+
+/// @brief Sizes, in instructions, of the systematic sampling scheme.
+/// Every period starts with WarmupSize instructions simulated in detail to
+/// fill the pipeline, followed by UnitSize measured instructions. The rest
+/// of the period is only functionally warmed.
+struct SamplingParameters
+{
+    uint64_t UnitSize = 1000;
+    uint64_t WarmupSize = 2000;
+    uint64_t Period = 100000;
+};
+
+/// @brief Outcome of a sampled simulation.
+struct SamplingResult
+{
+    uint64_t Instructions = 0;
+    uint64_t DetailedInstructions = 0;
+    vector<double> UnitCpi;
+};
+
+/// @brief Parses "UNIT:WARMUP:PERIOD" sampling sizes.
+inline bool ParseSamplingParameters(const char *text, SamplingParameters &parameters)
+{
+    unsigned long unitSize, warmupSize, period;
+    char extra;
+    if (sscanf(text, "%lu:%lu:%lu%c", &unitSize, &warmupSize, &period, &extra) != 3
+        || unitSize == 0 || warmupSize == 0 || period < unitSize + warmupSize)
+    {
+        return false;
+    }
+    parameters.UnitSize = unitSize;
+    parameters.WarmupSize = warmupSize;
+    parameters.Period = period;
+    return true;
+}
+
+/// @class SampledTraceSource
+/// @brief Hands out only the detailed part of each sampling period.
+/// Once the detailed instructions of a period are handed out the source
+/// reports the end of the trace so the pipeline drains. SkipToNextPeriod()
+/// then functionally warms the scheduler with the rest of the period.
+class SampledTraceSource : public TraceSource
+{
+    public:
+        SampledTraceSource(TraceSource *source, const SamplingParameters &parameters)
+        {
+            traceSource = source;
+            detailedSize = parameters.WarmupSize + parameters.UnitSize;
+            skippedSize = parameters.Period - detailedSize;
+        }
+
+        bool TryGetNext(TraceRecord &record) override
+        {
+            if (handedOut == detailedSize || !traceSource->TryGetNext(record))
+            {
+                return false;
+            }
+            handedOut++;
+            return true;
+        }
+
+        bool IsExhausted() override
+        {
+            return handedOut == detailedSize || traceSource->IsExhausted();
+        }
+
+        /// @brief Functionally warms the rest of the period.
+        /// @param scheduler Scheduler with an empty pipeline.
+        /// @return `true` if the trace has instructions for another period.
+        bool SkipToNextPeriod(Scheduler &scheduler)
+        {
+            TraceRecord record;
+            for (uint64_t i = 0; i < skippedSize && traceSource->TryGetNext(record); i++)
+            {
+                scheduler.FunctionallyWarm(record);
+            }
+            handedOut = 0;
+            return !traceSource->IsExhausted();
+        }
+
+    private:
+        TraceSource *traceSource;
+        uint64_t detailedSize;
+        uint64_t skippedSize;
+        uint64_t handedOut = 0;
+};
+
+/// @class SampleRecorder
+/// @brief Measures the cycles taken to retire each measurement unit.
+class SampleRecorder : public RetireObserver
+{
+    public:
+        SampleRecorder(const SamplingParameters &parameters)
+        {
+            samplingParameters = parameters;
+        }
+
+        void OnRetire(const Instruction &instruction) override
+        {
+            uint64_t offset = instruction.InstructionSequenceNumber % samplingParameters.Period;
+            int64_t retireCycle = instruction.GetBeginCycleValueForRegister(PipelineRegister::RT)
+                + instruction.GetEndCycleValueForRegister(PipelineRegister::RT);
+            if (offset == samplingParameters.WarmupSize - 1)
+            {
+                unitStartCycle = retireCycle;
+            }
+            else if (offset == samplingParameters.WarmupSize + samplingParameters.UnitSize - 1)
+            {
+                UnitCpi.push_back((double)(retireCycle - unitStartCycle) / samplingParameters.UnitSize);
+            }
+        }
+
+        vector<double> UnitCpi;
+
+    private:
+        SamplingParameters samplingParameters;
+        int64_t unitStartCycle = 0;
+};
+
+/// @brief Runs a systematically sampled simulation of a trace.
+/// @param source The full trace.
+/// @param params Processor configuration.
+/// @param opTypeByLatency Execution latency of each op type.
+/// @param parameters Sampling sizes.
+/// @param result [out] Measured CPI of each complete unit.
+/// @param architecturalRegisterCount Number of architectural registers in the trace.
+inline void RunSampledSimulation(TraceSource *source,
+                                 const proc_params &params,
+                                 const map<int, int> &opTypeByLatency,
+                                 const SamplingParameters &parameters,
+                                 SamplingResult &result,
+                                 unsigned long architecturalRegisterCount = DefaultArchitecturalRegisterCount)
+{
+    SampledTraceSource sampledSource(source, parameters);
+    SampleRecorder sampleRecorder(parameters);
+    Scheduler scheduler(&sampledSource, params.width, params.rob_size, params.iq_size, opTypeByLatency,
+                        architecturalRegisterCount);
+    scheduler.RetireObservers.push_back(&sampleRecorder);
+
+    uint64_t detailedInstructions = 0;
+    bool hasNextPeriod = true;
+    while (hasNextPeriod)
+    {
+        uint64_t periodStart = scheduler.FetchedInstructionsCount;
+        do
+        {
+            scheduler.RunCycle();
+            scheduler.FastForwardIdleCycles();
+        } while (scheduler.AdvanceToNextCycle());
+        detailedInstructions += scheduler.FetchedInstructionsCount - periodStart;
+        hasNextPeriod = sampledSource.SkipToNextPeriod(scheduler);
+    }
+
+    result.Instructions = scheduler.FetchedInstructionsCount;
+    result.DetailedInstructions = detailedInstructions;
+    result.UnitCpi = sampleRecorder.UnitCpi;
+}
+
+/// @brief Gets the two-sided 95% Student t critical value.
+/// @param degreesOfFreedom Number of samples minus one.
+inline double GetStudentT95(uint64_t degreesOfFreedom)
+{
+    static const double criticalValues[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degreesOfFreedom == 0)
+    {
+        return NAN;
+    }
+    if (degreesOfFreedom <= sizeof(criticalValues) / sizeof(criticalValues[0]))
+    {
+        return criticalValues[degreesOfFreedom - 1];
+    }
+    return 1.960;
+}
+
+/// @brief Prints the estimated IPC with its 95% confidence interval.
+inline void PrintSamplingResults(FILE *file, const SamplingParameters &parameters, const SamplingResult &result)
+{
+    uint64_t units = result.UnitCpi.size();
+    fprintf(file, "# Dynamic Instruction Count    = %" PRIu64 "\n", result.Instructions);
+    fprintf(file, "# Detailed Instructions        = %" PRIu64 "\n", result.DetailedInstructions);
+    fprintf(file, "# Sampled Units                = %" PRIu64 " x %" PRIu64 " instructions\n", units, parameters.UnitSize);
+    if (units == 0)
+    {
+        fprintf(file, "# Estimated IPC                = n/a (trace shorter than one unit)\n");
+        return;
+    }
+
+    double meanCpi = 0;
+    for (double cpi : result.UnitCpi)
+    {
+        meanCpi += cpi;
+    }
+    meanCpi /= units;
+    double variance = 0;
+    for (double cpi : result.UnitCpi)
+    {
+        variance += (cpi - meanCpi) * (cpi - meanCpi);
+    }
+    variance = units > 1 ? variance / (units - 1) : 0;
+
+    fprintf(file, "# Estimated Cycles             = %.0f\n", meanCpi * result.Instructions);
+    fprintf(file, "# Estimated IPC                = %1.2f\n", 1 / meanCpi);
+    if (units < 2)
+    {
+        fprintf(file, "# IPC 95%% Confidence Interval  = n/a (needs at least 2 units)\n");
+        return;
+    }
+    // The interval is computed on CPI, which is what the units average,
+    // and mapped to IPC by taking the reciprocal of both bounds.
+    double halfWidth = GetStudentT95(units - 1) * sqrt(variance / units);
+    double lowIpc = 1 / (meanCpi + halfWidth);
+    double highIpc = meanCpi > halfWidth ? 1 / (meanCpi - halfWidth) : INFINITY;
+    fprintf(file, "# IPC 95%% Confidence Interval  = [%1.2f, %1.2f] (+/- %.1f%%)\n",
+        lowIpc, highIpc, 100 * halfWidth / meanCpi);
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SCOREBOARD_H   // Include guard to prevent multiple inclusions
+#define SCOREBOARD_H
+
+#include <inttypes.h>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/// @class Scoreboard
+/// @brief One readiness bit per ROB value, packed 64 to a word.
+/// A bit is cleared when its ROB value is allocated and set when the result
+/// becomes available, so a readiness check is a single bit test. ROB values
+/// are allocated in order, so a bundle of consecutive ROB values is answered
+/// by one word operation.
+class Scoreboard
+{
+    public:
+        Scoreboard(unsigned long size) : bitCount(size), words((size + 63) / 64, 0)
+        {
+        }
+
+        /// @brief Marks the entry as ready.
+        /// @param index Rob value of the entry.
+        void Set(unsigned long index)
+        {
+            words[index / 64] |= Bit(index);
+        }
+
+        /// @brief Marks the entry as not ready.
+        /// @param index Rob value of the entry.
+        void Clear(unsigned long index)
+        {
+            words[index / 64] &= ~Bit(index);
+        }
+
+        /// @brief Gets whether the entry is ready.
+        /// @param index Rob value of the entry.
+        bool Test(unsigned long index) const
+        {
+            return (words[index / 64] & Bit(index)) != 0;
+        }
+
+        /// @brief Counts the consecutive ready entries starting at the index,
+        /// wrapping around at the end like the ROB does.
+        /// @param index Rob value of the first entry.
+        /// @param limit Maximum number of entries to count.
+        unsigned long CountReadyFrom(unsigned long index, unsigned long limit) const
+        {
+            unsigned long count = 0;
+            while (count < limit)
+            {
+                // Bits shifted in above the word are zero, so a run never
+                // crosses the end of a word.
+                uint64_t notReady = ~(words[index / 64] >> (index % 64));
+                unsigned long run = notReady == 0 ? 64 : __builtin_ctzll(notReady);
+                if (run == 0)
+                {
+                    break;
+                }
+                run = min(run, bitCount - index);
+                count += run;
+                index = index + run == bitCount ? 0 : index + run;
+            }
+            return min(count, limit);
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Vector(words);
+        }
+
+    private:
+        unsigned long bitCount;
+        vector<uint64_t> words;
+
+        static uint64_t Bit(unsigned long index)
+        {
+            return 1ULL << (index % 64);
+        }
+};
+
+#endif
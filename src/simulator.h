@@ -0,0 +1,132 @@
+#ifndef SIMULATOR_H   // Include guard to prevent multiple inclusions
+#define SIMULATOR_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sim.h"
+#include "instruction.h"
+#include "retire_observer.h"
+#include "trace_source.h"
+#include "stall_statistics.h"
+#include "rename_map_table.h"
+
+using namespace std;
+
+/// @brief Execution latency of each op type used by ./sim.
+inline map<int, int> GetDefaultOpTypeLatencies()
+{
+    return {{0, 1}, {1, 2}, {2, 5}};
+}
+
+/// @brief Processor configuration of a simulation.
+struct SimulatorConfig
+{
+    proc_params Params = {0, 0, 0};
+    map<int, int> OpTypeByLatency = GetDefaultOpTypeLatencies();
+    unsigned long ArchitecturalRegisterCount = DefaultArchitecturalRegisterCount;
+};
+
+/// @brief Counters of a simulation.
+struct SimulatorStats
+{
+    uint64_t Instructions = 0;
+    uint64_t Cycles = 0;
+    uint64_t RetiredInstructions = 0;
+    StallStatistics Statistics;
+
+    /// @brief Gets the instructions per cycle.
+    double GetIpc() const
+    {
+        return Cycles == 0 ? 0.0 : (double)Instructions / Cycles;
+    }
+};
+
+class SimulationEngine;
+class TraceReader;
+
+/// @class Simulator
+/// @brief Library interface to the out-of-order pipeline, built into libsim.a.
+/// A simulator runs one configuration over one trace. The trace is streamed
+/// from a file, replayed from records in memory or pulled from any
+/// TraceSource, and retired instructions are handed to observers or a
+/// callback in program order. Configurations with a specialized scheduler
+/// run on it, and every other configuration runs on the generic one; the
+/// scheduler types stay inside the library.
+class Simulator
+{
+    public:
+        Simulator(const SimulatorConfig &config);
+        ~Simulator();
+
+        Simulator(const Simulator&) = delete;
+        Simulator& operator=(const Simulator&) = delete;
+
+        /// @brief Simulates the trace pulled from the source, which must outlive the simulator.
+        void SetTrace(TraceSource *source);
+
+        /// @brief Simulates records already decoded into memory. They are
+        /// only read, so several simulators can share them.
+        void SetTrace(const TraceRecord *records, size_t count);
+
+        /// @brief Streams the trace from a text or binary trace file.
+        /// @return `true` if the file was opened, `false` otherwise.
+        bool OpenTrace(const char *fileName);
+
+        /// @brief Gets whether OpenTrace stopped reading at a malformed line.
+        bool HasMalformedTrace();
+
+        /// @brief Adds an observer notified for every retired instruction.
+        void AddRetireObserver(RetireObserver *observer);
+
+        /// @brief Calls the function for every retired instruction.
+        void SetRetireCallback(function<void(const Instruction&)> callback);
+
+        /// @brief Simulates one cycle, then skips the following cycles in
+        /// which nothing but execution latencies would change.
+        /// @return `false` once every instruction of the trace has retired.
+        bool Step();
+
+        /// @brief Simulates until every instruction of the trace has retired.
+        void Run();
+
+        /// @brief Gets the cycles simulated so far.
+        uint64_t GetCycles();
+
+        /// @brief Gets the instructions retired so far.
+        uint64_t GetRetiredInstructions();
+
+        /// @brief Gets the counters of the simulation so far.
+        SimulatorStats GetStats();
+
+        /// @brief Prints the per-stage profile. Empty unless built with -DSIM_PROFILE.
+        void PrintProfile(FILE *output);
+
+        /// @brief Gets whether the trace wrote registers beyond the architectural register count.
+        bool HasOutOfRangeRegister();
+
+        /// @brief Writes the complete simulator state between two cycles.
+        bool SaveCheckpoint(const char *fileName);
+
+        /// @brief Restores a checkpoint taken with the same configuration and
+        /// moves the trace, which must be at its start, past the fetched instructions.
+        /// @param error [out] Reason for a failure.
+        bool RestoreCheckpoint(const char *fileName, string &error);
+
+    private:
+        SimulatorConfig config;
+        unique_ptr<SimulationEngine> engine;
+        unique_ptr<TraceReader> traceReader;
+        unique_ptr<MemoryTraceSource> memoryTrace;
+        vector<RetireObserver*> retireObservers;
+        unique_ptr<RetireObserver> retireCallback;
+
+        void CreateEngine(TraceSource *source);
+};
+
+#endif
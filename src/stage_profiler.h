@@ -0,0 +1,139 @@
+#ifndef STAGE_PROFILER_H   // Include guard to prevent multiple inclusions
+#define STAGE_PROFILER_H
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#ifdef SIM_PROFILE
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+using namespace std;
+
+/// Pipeline stage functions timed by the profiler, in the order RunCycle calls them.
+enum ProfiledStage
+{
+    ProfileRetire,
+    ProfileWriteback,
+    ProfileExecute,
+    ProfileIssue,
+    ProfileDispatch,
+    ProfileRegisterRead,
+    ProfileRename,
+    ProfileDecode,
+    ProfileFetch,
+    ProfileFastForward,
+    TotalProfiledStages
+};
+
+#ifdef SIM_PROFILE
+
+/// @class StageProfiler
+/// @brief Times each stage function with the CPU's cycle counter and counts
+/// its calls and the instructions it moved. Only built with -DSIM_PROFILE
+/// (make PROFILE=1); otherwise every call compiles to nothing.
+class StageProfiler
+{
+    public:
+        static const bool Enabled = true;
+
+        uint64_t Ticks[TotalProfiledStages] = {};
+        uint64_t Calls[TotalProfiledStages] = {};
+        uint64_t Items[TotalProfiledStages] = {};
+
+        StageProfiler() : startTime(chrono::steady_clock::now()), startTicks(ReadTicks())
+        {
+        }
+
+        /// @brief Starts timing a stage call.
+        void Begin()
+        {
+            beginTicks = ReadTicks();
+        }
+
+        /// @brief Stops timing a stage call.
+        /// @param stage The stage that was called.
+        /// @param items Number of instructions the stage moved.
+        void End(ProfiledStage stage, uint64_t items)
+        {
+            Ticks[stage] += ReadTicks() - beginTicks;
+            Calls[stage]++;
+            Items[stage] += items;
+        }
+
+        /// @brief Prints the time spent in each stage.
+        /// @param output Stream to print to.
+        /// @param cycles Number of simulated cycles.
+        /// @param instructions Number of simulated instructions.
+        void Print(FILE *output, uint64_t cycles, uint64_t instructions)
+        {
+            static const char *stageNames[TotalProfiledStages] = {
+                "RetireInstructions", "WritebackToRegister", "Execute", "IssueInstruction",
+                "DispatchInstruction", "ReadRegister", "Rename", "DecodeInstruction",
+                "FetchInstruction", "FastForwardIdleCycles"};
+
+            // The tick rate is measured over the run instead of assumed.
+            double elapsedNs = chrono::duration<double, nano>(chrono::steady_clock::now() - startTime).count();
+            uint64_t elapsedTicks = ReadTicks() - startTicks;
+            double nsPerTick = elapsedTicks == 0 ? 0 : elapsedNs / elapsedTicks;
+            uint64_t totalTicks = 0;
+            for (int stage = 0; stage < TotalProfiledStages; stage++)
+            {
+                totalTicks += Ticks[stage];
+            }
+            double perCycle = cycles == 0 ? 1 : cycles;
+            double perInstruction = instructions == 0 ? 1 : instructions;
+
+            fprintf(output, "# === Stage Profile =============\n");
+            fprintf(output, "# %-22s %12s %12s %10s %10s %10s %6s\n",
+                    "stage", "calls", "items", "ms", "ns/cycle", "ns/instr", "share");
+            for (int stage = 0; stage < TotalProfiledStages; stage++)
+            {
+                double ns = Ticks[stage] * nsPerTick;
+                fprintf(output, "# %-22s %12" PRIu64 " %12" PRIu64 " %10.2f %10.2f %10.2f %5.1f%%\n",
+                        stageNames[stage], Calls[stage], Items[stage], ns / 1e6,
+                        ns / perCycle, ns / perInstruction,
+                        totalTicks == 0 ? 0.0 : 100.0 * Ticks[stage] / totalTicks);
+            }
+            fprintf(output, "# %-22s %12s %12s %10.2f %10.2f %10.2f\n", "Total (stages)", "", "",
+                    totalTicks * nsPerTick / 1e6, totalTicks * nsPerTick / perCycle,
+                    totalTicks * nsPerTick / perInstruction);
+            fprintf(output, "# %-22s %12s %12s %10.2f\n", "Total (wall)", "", "", elapsedNs / 1e6);
+        }
+
+    private:
+        chrono::steady_clock::time_point startTime;
+        uint64_t startTicks;
+        uint64_t beginTicks = 0;
+
+        static uint64_t ReadTicks()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
+};
+
+#else
+
+/// @class StageProfiler
+/// @brief Stand-in used when the profiler is compiled out; every call is empty.
+class StageProfiler
+{
+    public:
+        static const bool Enabled = false;
+
+        void Begin() {}
+        void End(ProfiledStage, uint64_t) {}
+        void Print(FILE*, uint64_t, uint64_t) {}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef STALL_STATISTICS_H   // Include guard to prevent multiple inclusions
+#define STALL_STATISTICS_H
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <array>
+
+using namespace std;
+
+/// @brief Early-return points of the pipeline stages.
+enum StallReason
+{
+    FetchDecodeBusy,            // DE still holds the previous bundle
+    FetchNoInstructions,        // The trace has nothing left to hand out
+    DecodeRenameFull,           // RN cannot accept the decode bundle
+    RenameRegisterReadBusy,     // RR still holds the previous bundle
+    RenameRobFull,              // Too few free ROB entries for the rename bundle
+    RegisterReadDispatchFull,   // DI cannot accept the register-read bundle
+    DispatchIqFull,             // Too few free IQ entries for the dispatch bundle
+    IssueOperandsNotReady,      // The IQ holds instructions but none is ready
+    RetireRobEmpty,             // Nothing in flight
+    RetireHeadNotReady,         // The ROB head has not finished executing
+    TotalStallReasons
+};
+
+/// @brief Components of the CPI stack.
+enum CpiComponent
+{
+    CpiBase,
+    CpiRobFull,
+    CpiIqFull,
+    CpiDependencyWait,
+    CpiDrain,
+    TotalCpiComponents
+};
+
+/// @class StallStatistics
+/// @brief Per-cycle stall counters, ROB and IQ occupancy and the CPI stack.
+/// Stages report their early returns with Stall() and the scheduler closes
+/// every simulated cycle with EndCycles(). Each cycle has WIDTH retire slots:
+/// used slots are base CPI, and unused slots are charged to the most
+/// upstream reason the retire stage could not fill them.
+class StallStatistics
+{
+    public:
+        std::array<uint64_t, TotalStallReasons> StallCycles = {};
+        std::array<uint64_t, TotalCpiComponents> RetireSlots = {};
+        uint64_t RobOccupancySum = 0;
+        uint64_t IqOccupancySum = 0;
+        uint64_t Cycles = 0;
+
+        /// @brief Records that a stage stalled in the current cycle.
+        /// @param reason The early return the stage took.
+        void Stall(StallReason reason)
+        {
+            cycleStalls |= 1u << reason;
+        }
+
+        /// @brief Accounts for cycles that all stalled as recorded since the last call.
+        /// @param cycles Number of cycles to account for.
+        /// @param retired Instructions retired in each of those cycles.
+        /// @param width Retire width.
+        /// @param robOccupancy Occupied ROB entries at the end of the cycles.
+        /// @param iqOccupancy Occupied IQ entries at the end of the cycles.
+        void EndCycles(uint64_t cycles, unsigned long retired, unsigned long width,
+                       unsigned long robOccupancy, unsigned long iqOccupancy)
+        {
+            for (uint32_t stalls = cycleStalls; stalls != 0; stalls &= stalls - 1)
+            {
+                StallCycles[__builtin_ctz(stalls)] += cycles;
+            }
+            RetireSlots[CpiBase] += retired * cycles;
+            RetireSlots[ClassifyEmptySlots()] += (width - retired) * cycles;
+            RobOccupancySum += robOccupancy * cycles;
+            IqOccupancySum += iqOccupancy * cycles;
+            Cycles += cycles;
+            cycleStalls = 0;
+        }
+
+        /// @brief Prints the stall counters, average occupancies and CPI stack.
+        /// @param output Stream to print to.
+        /// @param instructions Number of retired instructions.
+        /// @param width Retire width.
+        void Print(FILE *output, uint64_t instructions, unsigned long width)
+        {
+            static const char *stallNames[TotalStallReasons] = {
+                "Fetch: DE busy", "Fetch: trace empty", "Decode: RN full",
+                "Rename: RR busy", "Rename: ROB full", "RegRead: DI full",
+                "Dispatch: IQ full", "Issue: operands not ready",
+                "Retire: ROB empty", "Retire: head not ready"};
+            static const char *cpiNames[TotalCpiComponents] = {
+                "Base", "ROB full", "IQ full", "Dependency wait", "Drain"};
+            double cycles = Cycles == 0 ? 1 : Cycles;
+
+            fprintf(output, "# === Stall Cycles ==============\n");
+            for (int reason = 0; reason < TotalStallReasons; reason++)
+            {
+                fprintf(output, "# %-28s = %" PRIu64 " (%.1f%%)\n", stallNames[reason],
+                        StallCycles[reason], 100.0 * StallCycles[reason] / cycles);
+            }
+            fprintf(output, "# %-28s = %.2f\n", "Average ROB occupancy", RobOccupancySum / cycles);
+            fprintf(output, "# %-28s = %.2f\n", "Average IQ occupancy", IqOccupancySum / cycles);
+
+            fprintf(output, "# === CPI Stack =================\n");
+            double slotsPerCpi = (double)width * (instructions == 0 ? 1 : instructions);
+            for (int component = 0; component < TotalCpiComponents; component++)
+            {
+                fprintf(output, "# %-28s = %.4f (%.1f%%)\n", cpiNames[component],
+                        RetireSlots[component] / slotsPerCpi, 100.0 * RetireSlots[component] / (cycles * width));
+            }
+            fprintf(output, "# %-28s = %.4f\n", "Total CPI", Cycles / slotsPerCpi * width);
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Value(StallCycles);
+            archive.Value(RetireSlots);
+            archive.Value(RobOccupancySum);
+            archive.Value(IqOccupancySum);
+            archive.Value(Cycles);
+        }
+
+    private:
+        uint32_t cycleStalls = 0;
+
+        bool HasStalled(StallReason reason)
+        {
+            return (cycleStalls >> reason) & 1;
+        }
+
+        // Retire slots that go unused while the front end has nothing left
+        // (or has not filled the window yet) are drain. Otherwise a full
+        // window, ROB before IQ, is what kept younger work from starting,
+        // and anything else is the head waiting on its producers.
+        CpiComponent ClassifyEmptySlots()
+        {
+            if (HasStalled(RetireRobEmpty) || HasStalled(FetchNoInstructions))
+            {
+                return CpiDrain;
+            }
+            if (HasStalled(RenameRobFull))
+            {
+                return CpiRobFull;
+            }
+            if (HasStalled(DispatchIqFull))
+            {
+                return CpiIqFull;
+            }
+            return CpiDependencyWait;
+        }
+};
+
+#endif
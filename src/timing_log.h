@@ -0,0 +1,335 @@
+#ifndef TIMING_LOG_H   // Include guard to prevent multiple inclusions
+#define TIMING_LOG_H
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <vector>
+#include "sim.h"
+#include "instruction.h"
+#include "retire_observer.h"
+#include "binary_trace.h"
+
+using namespace std;
+
+// Timing log layout (all fixed-size integers little endian):
+//
+//   header:  "OOOTIMES" | uint32 version | uint32 column count
+//   block:   uint32 record count | column count x uint32 column bytes
+//            | the columns, one after another
+//
+// Each column holds one field of every record of the block as zigzag
+// varints. Sequence numbers, PCs and stage begin cycles are stored as the
+// difference to the previous record of the block, so a block decodes on
+// its own and the usual values take one byte. A reader can skip the
+// columns it does not need by their sizes.
+const char TimingLogMagic[8] = {'O', 'O', 'O', 'T', 'I', 'M', 'E', 'S'};
+const uint32_t TimingLogVersion = 1;
+const size_t TimingLogHeaderSize = 16;
+
+/// Columns of a timing log, in file order.
+enum TimingLogColumn
+{
+    LogSequenceNumber,
+    LogProgramCounter,
+    LogOpType,
+    LogDestinationRegister,
+    LogSourceRegister1,
+    LogSourceRegister2,
+    LogBeginCycle,                                      // One per pipeline register, FE to RT
+    LogDuration = LogBeginCycle + TotalPipelineRegisters,  // One per pipeline register, FE to RT
+    TotalTimingLogColumns = LogDuration + TotalPipelineRegisters
+};
+
+/// Mask that selects every column.
+const uint32_t AllTimingLogColumns = (1u << TotalTimingLogColumns) - 1;
+
+/// @brief Gets whether the column is stored as a difference to the previous record.
+inline bool IsDeltaEncodedColumn(int column)
+{
+    return column == LogSequenceNumber || column == LogProgramCounter
+        || (column >= LogBeginCycle && column < LogDuration);
+}
+
+inline void AppendZigzagVarint(vector<uint8_t> &out, int64_t value)
+{
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (zigzag >= 0x80)
+    {
+        out.push_back((uint8_t)(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back((uint8_t)zigzag);
+}
+
+inline bool ReadZigzagVarint(const uint8_t *&in, const uint8_t *end, int64_t &value)
+{
+    uint64_t zigzag = 0;
+    int shift = 0;
+    do
+    {
+        if (in == end || shift > 63)
+        {
+            return false;
+        }
+        zigzag |= (uint64_t)(*in & 0x7F) << shift;
+        shift += 7;
+    } while (*in++ & 0x80);
+    value = (int64_t)((zigzag >> 1) ^ (0 - (zigzag & 1)));
+    return true;
+}
+
+/// @class TimingLogWriter
+/// @brief Writes the timings of retired instructions as a columnar binary log.
+/// Records are encoded into per-column buffers as they retire and written
+/// out as one block every BlockRecords instructions, so memory use does not
+/// depend on the length of the trace.
+class TimingLogWriter : public RetireObserver
+{
+    public:
+        static const uint32_t BlockRecords = 4096;
+
+        ~TimingLogWriter()
+        {
+            Close();
+        }
+
+        /// @brief Creates the log and writes its header.
+        /// @param fileName Path of the log to write.
+        bool Open(const char *fileName)
+        {
+            outputFile = fopen(fileName, "wb");
+            if (outputFile == NULL)
+            {
+                return false;
+            }
+            uint8_t header[TimingLogHeaderSize];
+            memcpy(header, TimingLogMagic, sizeof(TimingLogMagic));
+            StoreLittleEndian(header + 8, TimingLogVersion, 4);
+            StoreLittleEndian(header + 12, TotalTimingLogColumns, 4);
+            failed = fwrite(header, 1, sizeof(header), outputFile) != sizeof(header);
+            StartBlock();
+            return !failed;
+        }
+
+        void OnRetire(const Instruction &instruction) override
+        {
+            if (outputFile == NULL)
+            {
+                return;
+            }
+            int64_t values[TotalTimingLogColumns];
+            values[LogSequenceNumber] = instruction.InstructionSequenceNumber;
+            values[LogProgramCounter] = instruction.ProgramCounter;
+            values[LogOpType] = instruction.OpType;
+            values[LogDestinationRegister] = instruction.DestinationRegister.Value;
+            values[LogSourceRegister1] = instruction.SourceRegister1.Value;
+            values[LogSourceRegister2] = instruction.SourceRegister2.Value;
+            for (int stage = 0; stage < TotalPipelineRegisters; stage++)
+            {
+                values[LogBeginCycle + stage] = instruction.GetBeginCycleValueForRegister((PipelineRegister)stage);
+                values[LogDuration + stage] = instruction.GetEndCycleValueForRegister((PipelineRegister)stage);
+            }
+            for (int column = 0; column < TotalTimingLogColumns; column++)
+            {
+                int64_t value = values[column];
+                if (IsDeltaEncodedColumn(column))
+                {
+                    value -= previousValues[column];
+                    previousValues[column] = values[column];
+                }
+                AppendZigzagVarint(columns[column], value);
+            }
+            if (++blockRecordCount == BlockRecords)
+            {
+                Flush();
+            }
+        }
+
+        /// @brief Writes out the records retired so far as a block and pushes it to the file.
+        void Flush()
+        {
+            if (outputFile == NULL || blockRecordCount == 0)
+            {
+                return;
+            }
+            uint8_t header[4 + 4 * TotalTimingLogColumns];
+            StoreLittleEndian(header, blockRecordCount, 4);
+            for (int column = 0; column < TotalTimingLogColumns; column++)
+            {
+                StoreLittleEndian(header + 4 + 4 * column, columns[column].size(), 4);
+            }
+            failed = fwrite(header, 1, sizeof(header), outputFile) != sizeof(header) || failed;
+            for (auto &column : columns)
+            {
+                failed = fwrite(column.data(), 1, column.size(), outputFile) != column.size() || failed;
+            }
+            failed = fflush(outputFile) != 0 || failed;
+            StartBlock();
+        }
+
+        /// @brief Writes the last block and closes the log.
+        /// @return `true` if everything was written.
+        bool Close()
+        {
+            if (outputFile == NULL)
+            {
+                return !failed;
+            }
+            Flush();
+            failed = fclose(outputFile) != 0 || failed;
+            outputFile = NULL;
+            return !failed;
+        }
+
+    private:
+        FILE *outputFile = NULL;
+        bool failed = false;
+        uint32_t blockRecordCount = 0;
+        vector<uint8_t> columns[TotalTimingLogColumns];
+        int64_t previousValues[TotalTimingLogColumns];
+
+        void StartBlock()
+        {
+            blockRecordCount = 0;
+            for (auto &column : columns)
+            {
+                column.clear();
+            }
+            memset(previousValues, 0, sizeof(previousValues));
+        }
+};
+
+/// @brief Decoded columns of one block of a timing log.
+struct TimingLogBlock
+{
+    uint32_t RecordCount = 0;
+    vector<int64_t> Columns[TotalTimingLogColumns];
+
+    /// @brief Rebuilds a retired instruction from a record, for FormatTimingLine.
+    /// Needs every column.
+    /// @param record Index of the record in the block.
+    /// @param instruction [out] The instruction with its stage timings.
+    void GetInstruction(uint32_t record, Instruction &instruction) const
+    {
+        int destination = Columns[LogDestinationRegister][record];
+        int source1 = Columns[LogSourceRegister1][record];
+        int source2 = Columns[LogSourceRegister2][record];
+        instruction = Instruction(Columns[LogProgramCounter][record],
+                                  Columns[LogOpType][record],
+                                  {destination, false, destination != -1},
+                                  {source1, false, source1 != -1},
+                                  {source2, false, source2 != -1},
+                                  Columns[LogSequenceNumber][record],
+                                  Columns[LogBeginCycle + PipelineRegister::FE][record]);
+        for (int stage = 0; stage < TotalPipelineRegisters; stage++)
+        {
+            instruction.SetBeginCycleForRegister((PipelineRegister)stage, Columns[LogBeginCycle + stage][record]);
+            instruction.SetEndCycleForRegister((PipelineRegister)stage, Columns[LogDuration + stage][record]);
+        }
+    }
+};
+
+/// @class TimingLogReader
+/// @brief Reads a timing log block by block, decoding only the requested columns.
+class TimingLogReader
+{
+    public:
+        ~TimingLogReader()
+        {
+            if (inputFile != NULL)
+            {
+                fclose(inputFile);
+            }
+        }
+
+        /// @brief Opens the log and checks its header.
+        /// @param fileName Path of the log.
+        bool Open(const char *fileName)
+        {
+            inputFile = fopen(fileName, "rb");
+            if (inputFile == NULL)
+            {
+                return false;
+            }
+            uint8_t header[TimingLogHeaderSize];
+            return fread(header, 1, sizeof(header), inputFile) == sizeof(header)
+                && memcmp(header, TimingLogMagic, sizeof(TimingLogMagic)) == 0
+                && LoadLittleEndian(header + 8, 4) == TimingLogVersion
+                && LoadLittleEndian(header + 12, 4) == TotalTimingLogColumns;
+        }
+
+        /// @brief Reads the next block.
+        /// @param block [out] The block; columns outside the mask are left empty.
+        /// @param columnMask Bit i selects column i.
+        /// @return `false` at the end of the log or on a corrupt block.
+        bool ReadBlock(TimingLogBlock &block, uint32_t columnMask = AllTimingLogColumns)
+        {
+            uint8_t header[4 + 4 * TotalTimingLogColumns];
+            size_t headerBytes = fread(header, 1, sizeof(header), inputFile);
+            if (headerBytes != sizeof(header))
+            {
+                corrupt = headerBytes != 0;
+                return false;
+            }
+            block.RecordCount = LoadLittleEndian(header, 4);
+            for (int column = 0; column < TotalTimingLogColumns; column++)
+            {
+                size_t columnBytes = LoadLittleEndian(header + 4 + 4 * column, 4);
+                block.Columns[column].clear();
+                if ((columnMask & (1u << column)) == 0)
+                {
+                    if (fseek(inputFile, columnBytes, SEEK_CUR) != 0)
+                    {
+                        corrupt = true;
+                        return false;
+                    }
+                    continue;
+                }
+                buffer.resize(columnBytes);
+                if (fread(buffer.data(), 1, columnBytes, inputFile) != columnBytes
+                    || !DecodeColumn(column, block.RecordCount, block.Columns[column]))
+                {
+                    corrupt = true;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// @brief Gets whether reading stopped at a truncated or corrupt block.
+        bool IsCorrupt()
+        {
+            return corrupt;
+        }
+
+    private:
+        FILE *inputFile = NULL;
+        vector<uint8_t> buffer;
+        bool corrupt = false;
+
+        bool DecodeColumn(int column, uint32_t recordCount, vector<int64_t> &values)
+        {
+            const uint8_t *in = buffer.data();
+            const uint8_t *end = in + buffer.size();
+            int64_t value = 0;
+            int64_t previous = 0;
+            values.resize(recordCount);
+            for (uint32_t record = 0; record < recordCount; record++)
+            {
+                if (!ReadZigzagVarint(in, end, value))
+                {
+                    return false;
+                }
+                if (IsDeltaEncodedColumn(column))
+                {
+                    value += previous;
+                    previous = value;
+                }
+                values[record] = value;
+            }
+            return in == end;
+        }
+};
+
+#endif
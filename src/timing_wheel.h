@@ -0,0 +1,125 @@
+#ifndef TIMING_WHEEL_H   // Include guard to prevent multiple inclusions
+#define TIMING_WHEEL_H
+
+#include <inttypes.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+/// @class TimingWheel
+/// @brief Executing instructions bucketed by the cycle they finish in.
+/// An instruction issued in cycle C with latency L finishes in cycle C + L,
+/// so every instruction in flight finishes within the maximum latency and
+/// one bucket per cycle of that window is enough. Each cycle only drains
+/// its own bucket; instructions still executing are not touched. Buckets
+/// keep issue order. Storage is sized once at construction.
+class TimingWheel
+{
+    public:
+        /// @param width Pipeline width, the most instructions issued per cycle.
+        /// @param latencyByOpType Execution latency of each op type.
+        TimingWheel(unsigned long width, const map<int, int> &latencyByOpType)
+        {
+            // Instructions finishing in the same cycle were issued in
+            // different cycles, one per distinct latency. The scheduler
+            // executes latencies below one cycle as one cycle.
+            set<int> latencies = {1};
+            int maximumLatency = 1;
+            for (auto &opTypeLatency : latencyByOpType)
+            {
+                latencies.insert(opTypeLatency.second);
+                maximumLatency = max(maximumLatency, opTypeLatency.second);
+            }
+            unsigned long bucketCount = 1;
+            while (bucketCount < (unsigned long)maximumLatency)
+            {
+                bucketCount *= 2;
+            }
+            bucketMask = bucketCount - 1;
+            bucketCapacity = width * latencies.size();
+            bucketSizes.assign(bucketCount, 0);
+            entries.assign(bucketCount * bucketCapacity, -1);
+        }
+
+        /// @brief Adds an instruction that finishes in the given cycle.
+        /// @param instructionIndex Arena index of the instruction.
+        /// @param completionCycle Cycle in which the instruction finishes
+        /// executing, within the maximum latency of the current cycle.
+        void Insert(int instructionIndex, uint64_t completionCycle)
+        {
+            unsigned long bucket = completionCycle & bucketMask;
+            entries[bucket * bucketCapacity + bucketSizes[bucket]] = instructionIndex;
+            bucketSizes[bucket]++;
+            count++;
+        }
+
+        /// @brief Removes every instruction finishing in the cycle, in issue order.
+        /// @param cycle The current cycle.
+        /// @param action Callable taking the arena index of an instruction.
+        template <typename Action>
+        void DrainCompleted(uint64_t cycle, Action action)
+        {
+            unsigned long bucket = cycle & bucketMask;
+            unsigned long size = bucketSizes[bucket];
+            const int *bucketEntries = &entries[bucket * bucketCapacity];
+            for (unsigned long i = 0; i < size; i++)
+            {
+                action(bucketEntries[i]);
+            }
+            bucketSizes[bucket] = 0;
+            count -= size;
+        }
+
+        /// @brief Finds the first cycle, from the given one on, in which an instruction finishes.
+        /// @param cycle The current cycle; its bucket must not hold earlier cycles.
+        /// @param completionCycle [out] The first cycle with a finishing instruction.
+        /// @return `true` if an instruction is executing, `false` otherwise.
+        bool TryGetNextCompletion(uint64_t cycle, uint64_t &completionCycle)
+        {
+            if (count == 0)
+            {
+                return false;
+            }
+            for (uint64_t next = cycle; ; next++)
+            {
+                if (bucketSizes[next & bucketMask] != 0)
+                {
+                    completionCycle = next;
+                    return true;
+                }
+            }
+        }
+
+        /// @brief Gets the number of executing instructions.
+        unsigned long GetSize()
+        {
+            return count;
+        }
+
+        /// @brief Gets whether no instruction is executing.
+        bool IsEmpty()
+        {
+            return count == 0;
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Value(count);
+            archive.Array(bucketSizes.data(), bucketSizes.size());
+            archive.Array(entries.data(), entries.size());
+        }
+
+    private:
+        unsigned long bucketMask;
+        unsigned long bucketCapacity;
+        unsigned long count = 0;
+        vector<unsigned long> bucketSizes;
+        vector<int> entries;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TIMING_WRITER_H   // Include guard to prevent multiple inclusions
+#define TIMING_WRITER_H
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <vector>
+#include "sim.h"
+#include "instruction.h"
+#include "retire_observer.h"
+
+using namespace std;
+
+/// Upper bound on the length of one formatted timing line.
+const size_t MaxTimingLineLength = 512;
+
+/// @brief Formats the per-stage timing line of an instruction.
+/// @param instruction The retired instruction.
+/// @param line [out] Buffer of at least MaxTimingLineLength bytes.
+/// @return Number of characters written, excluding the terminating null.
+inline int FormatTimingLine(const Instruction &instruction, char *line)
+{
+    return snprintf(line, MaxTimingLineLength,
+        "%" PRIu64 " fu{%d} src{%d,%d} dst{%d} "
+        "FE{%" PRId64 ",%d} DE{%" PRId64 ",%d} RN{%" PRId64 ",%d} RR{%" PRId64 ",%d} DI{%" PRId64 ",%d} "
+        "IS{%" PRId64 ",%d} EX{%" PRId64 ",%d} WB{%" PRId64 ",%d} RT{%" PRId64 ",%d}\n",
+        instruction.InstructionSequenceNumber,
+        instruction.OpType,
+        instruction.SourceRegister1.Value,
+        instruction.SourceRegister2.Value,
+        instruction.DestinationRegister.Value,
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::FE),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::FE),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::DE),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::DE),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::RN),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::RN),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::RR),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::RR),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::DI),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::DI),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::IS),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::IS),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::EX),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::EX),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::WB),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::WB),
+        instruction.GetBeginCycleValueForRegister(PipelineRegister::RT),
+        instruction.GetEndCycleValueForRegister(PipelineRegister::RT));
+}
+
+/// @class TimingWriter
+/// @brief Streams the timing line of each instruction as it retires.
+/// Lines are formatted into a fixed-size buffer that is written out when
+/// full, so memory use does not grow with the length of the trace.
+class TimingWriter : public RetireObserver
+{
+    public:
+        TimingWriter(FILE *file, size_t bufferSize = 1 << 16) : buffer(bufferSize + MaxTimingLineLength)
+        {
+            outputFile = file;
+            flushThreshold = bufferSize;
+        }
+
+        ~TimingWriter()
+        {
+            Flush();
+        }
+
+        /// @brief Formats the timing line of the retired instruction.
+        /// @param instruction The retired instruction.
+        void OnRetire(const Instruction &instruction) override
+        {
+            usedBytes += FormatTimingLine(instruction, &buffer[usedBytes]);
+            if (usedBytes >= flushThreshold)
+            {
+                Flush();
+            }
+        }
+
+        /// @brief Writes the buffered lines to the output file.
+        void Flush()
+        {
+            if (usedBytes == 0)
+            {
+                return;
+            }
+            fwrite(buffer.data(), 1, usedBytes, outputFile);
+            usedBytes = 0;
+        }
+
+    private:
+        FILE *outputFile;
+        vector<char> buffer;
+        size_t usedBytes = 0;
+        size_t flushThreshold;
+};
+
+#endif
@@ -0,0 +1,405 @@
+#ifndef TRACE_READER_H   // Include guard to prevent multiple inclusions
+#define TRACE_READER_H
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <vector>
+#include "sim.h"
+#include "binary_trace.h"
+#include "trace_source.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRACE_READER_HAS_MMAP 1
+#endif
+
+using namespace std;
+
+/// @class TraceReader
+/// @brief Reads and decodes a trace ahead of fetch.
+/// The trace file is memory mapped when possible and read in large blocks
+/// otherwise. Text and binary traces are told apart by the binary header.
+/// Records are decoded in batches into a buffer of TraceRecord values that
+/// fetch pops from.
+class TraceReader : public TraceSource
+{
+    public:
+        TraceReader() : records(RecordBatchSize), recordOffsets(RecordBatchSize)
+        {
+        }
+
+        ~TraceReader()
+        {
+            Close();
+        }
+
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+
+        /// @brief Opens the trace file.
+        /// @param fileName Path to the trace file.
+        /// @return `true` if the file was opened, `false` otherwise.
+        bool Open(const char *fileName)
+        {
+            Close();
+#ifdef TRACE_READER_HAS_MMAP
+            int fileDescriptor = open(fileName, O_RDONLY);
+            if (fileDescriptor < 0)
+            {
+                return false;
+            }
+            struct stat fileStatus;
+            if (fstat(fileDescriptor, &fileStatus) == 0 && S_ISREG(fileStatus.st_mode) && fileStatus.st_size > 0)
+            {
+                void *mapping = mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+                if (mapping != MAP_FAILED)
+                {
+                    madvise(mapping, fileStatus.st_size, MADV_SEQUENTIAL);
+                    mappedData = (const char*)mapping;
+                    mappedSize = fileStatus.st_size;
+                    cursor = mappedData;
+                    parseEnd = dataEnd = mappedData + mappedSize;
+                    ::close(fileDescriptor);
+                    DetectFormat();
+                    return true;
+                }
+            }
+            ::close(fileDescriptor);
+#endif
+            traceFile = fopen(fileName, "rb");
+            if (traceFile == NULL)
+            {
+                return false;
+            }
+            blockBuffer.resize(BlockSize);
+            blockOffset = 0;
+            size_t headerBytes = fread(blockBuffer.data(), 1, BinaryTraceHeaderSize, traceFile);
+            cursor = parseEnd = blockBuffer.data();
+            dataEnd = cursor + headerBytes;
+            DetectFormat();
+            // Anything after the header is parsed once the first block is loaded.
+            parseEnd = cursor;
+            return true;
+        }
+
+        /// @brief Attempts to get the next decoded trace record.
+        /// @param record [out] Reference where the next record will be stored if available.
+        /// @return `true` if a record was available, `false` at the end of the trace.
+        bool TryGetNext(TraceRecord &record) override
+        {
+            if (nextRecord == decodedRecords && !Refill())
+            {
+                return false;
+            }
+            record = records[nextRecord++];
+            return true;
+        }
+
+        /// @brief Gets whether every record of the trace has been handed out.
+        bool IsExhausted() override
+        {
+            return nextRecord == decodedRecords && !Refill();
+        }
+
+        bool TryGetPosition(TracePosition &position) override
+        {
+            position.Format = isBinary ? BinaryTracePosition : TextTracePosition;
+            if (nextRecord == decodedRecords)
+            {
+                position.Offset = GetFileOffset();
+                position.PreviousPc = previousPc;
+            }
+            else
+            {
+                position.Offset = recordOffsets[nextRecord];
+                position.PreviousPc = nextRecord == 0 ? batchPreviousPc : records[nextRecord - 1].ProgramCounter;
+            }
+            return true;
+        }
+
+        /// @brief Moves to a position of the same trace file. Traces read
+        /// from a pipe cannot seek.
+        bool Seek(const TracePosition &position) override
+        {
+            if (position.Format != (uint64_t)(isBinary ? BinaryTracePosition : TextTracePosition))
+            {
+                return false;
+            }
+            if (mappedData != NULL)
+            {
+                if (position.Offset > mappedSize)
+                {
+                    return false;
+                }
+                cursor = mappedData + position.Offset;
+            }
+            else
+            {
+                if (traceFile == NULL || fseeko(traceFile, position.Offset, SEEK_SET) != 0)
+                {
+                    return false;
+                }
+                blockOffset = position.Offset;
+                cursor = parseEnd = dataEnd = blockBuffer.data();
+            }
+            decodedRecords = nextRecord = 0;
+            malformedLine = false;
+            previousPc = position.PreviousPc;
+            return true;
+        }
+
+        /// @brief Gets whether the trace is in the binary format.
+        bool IsBinary()
+        {
+            return isBinary;
+        }
+
+        /// @brief Gets whether decoding stopped at a line that is not a valid record.
+        bool HasMalformedLine()
+        {
+            return malformedLine;
+        }
+
+    private:
+        static const size_t RecordBatchSize = 4096;
+        static const size_t BlockSize = 1 << 20;
+
+        vector<TraceRecord> records;
+        vector<uint64_t> recordOffsets;     // File offset of each decoded record
+        size_t decodedRecords = 0;
+        size_t nextRecord = 0;
+        bool malformedLine = false;
+        bool isBinary = false;
+        uint64_t previousPc = 0;
+        uint64_t batchPreviousPc = 0;       // previousPc before the first record of the batch
+
+        // Characters in [cursor, parseEnd) only hold complete lines, or for
+        // binary traces, start complete records.
+        const char *cursor = NULL;
+        const char *parseEnd = NULL;
+
+        const char *mappedData = NULL;
+        size_t mappedSize = 0;
+
+        FILE *traceFile = NULL;
+        vector<char> blockBuffer;
+        uint64_t blockOffset = 0;           // File offset of blockBuffer[0]
+        const char *dataEnd = NULL;
+
+        void Close()
+        {
+#ifdef TRACE_READER_HAS_MMAP
+            if (mappedData != NULL)
+            {
+                munmap((void*)mappedData, mappedSize);
+                mappedData = NULL;
+            }
+#endif
+            if (traceFile != NULL)
+            {
+                fclose(traceFile);
+                traceFile = NULL;
+            }
+            cursor = parseEnd = dataEnd = NULL;
+            decodedRecords = nextRecord = 0;
+            malformedLine = false;
+            isBinary = false;
+            previousPc = 0;
+        }
+
+        uint64_t GetFileOffset()
+        {
+            return mappedData != NULL ? cursor - mappedData : blockOffset + (cursor - blockBuffer.data());
+        }
+
+        void DetectFormat()
+        {
+            isBinary = IsBinaryTrace(cursor, dataEnd - cursor);
+            if (isBinary)
+            {
+                cursor += BinaryTraceHeaderSize;
+            }
+        }
+
+        /// @brief Decodes the next batch of records into the record buffer.
+        bool Refill()
+        {
+            decodedRecords = 0;
+            nextRecord = 0;
+            batchPreviousPc = previousPc;
+            while (decodedRecords < RecordBatchSize && !malformedLine)
+            {
+                if (!isBinary)
+                {
+                    SkipWhitespace();
+                }
+                if (cursor >= parseEnd)
+                {
+                    if (!LoadNextBlock())
+                    {
+                        break;
+                    }
+                    continue;
+                }
+                recordOffsets[decodedRecords] = GetFileOffset();
+                bool decoded = isBinary
+                    ? DecodeBinaryRecord(cursor, dataEnd, previousPc, records[decodedRecords])
+                    : ParseRecord(records[decodedRecords]);
+                if (!decoded)
+                {
+                    malformedLine = true;
+                    break;
+                }
+                decodedRecords++;
+            }
+            return decodedRecords != 0;
+        }
+
+        /// @brief Reads the next block of a non-mapped trace, keeping any partial line or record.
+        bool LoadNextBlock()
+        {
+            if (traceFile == NULL)
+            {
+                return false;
+            }
+            size_t carried = dataEnd - cursor;
+            blockOffset = GetFileOffset();
+            memmove(blockBuffer.data(), cursor, carried);
+            char *blockEnd = blockBuffer.data() + carried;
+            size_t bytesRead = 0;
+            while (true)
+            {
+                if ((size_t)(blockEnd - blockBuffer.data()) == blockBuffer.size())
+                {
+                    blockBuffer.resize(blockBuffer.size() * 2);
+                    blockEnd = blockBuffer.data() + carried + bytesRead;
+                }
+                size_t chunk = fread(blockEnd, 1, blockBuffer.data() + blockBuffer.size() - blockEnd, traceFile);
+                blockEnd += chunk;
+                bytesRead += chunk;
+                if (chunk == 0)
+                {
+                    break;
+                }
+                if (isBinary ? (size_t)(blockEnd - blockBuffer.data()) >= MaxBinaryRecordSize
+                             : memchr(blockEnd - chunk, '\n', chunk) != NULL)
+                {
+                    break;
+                }
+            }
+            cursor = blockBuffer.data();
+            dataEnd = blockEnd;
+            if (bytesRead == 0)
+            {
+                // End of file: whatever is left is the final line.
+                parseEnd = dataEnd;
+                fclose(traceFile);
+                traceFile = NULL;
+                return carried != 0;
+            }
+            if (isBinary)
+            {
+                // Any record starting before parseEnd is complete.
+                size_t available = dataEnd - cursor;
+                parseEnd = available >= MaxBinaryRecordSize ? dataEnd - (MaxBinaryRecordSize - 1) : cursor;
+                return true;
+            }
+            const char *lastNewline = dataEnd;
+            while (lastNewline != cursor && lastNewline[-1] != '\n')
+            {
+                lastNewline--;
+            }
+            parseEnd = lastNewline;
+            return true;
+        }
+
+        void SkipWhitespace()
+        {
+            while (cursor != parseEnd && IsWhitespace(*cursor))
+            {
+                cursor++;
+            }
+        }
+
+        static bool IsWhitespace(char character)
+        {
+            return character == ' ' || character == '\n' || character == '\t' || character == '\r';
+        }
+
+        /// @brief Decodes one "<pc> <op> <dst> <src1> <src2>" line.
+        bool ParseRecord(TraceRecord &record)
+        {
+            return ParseHex(record.ProgramCounter)
+                && ParseInt(record.OpType)
+                && ParseInt(record.DestinationRegister)
+                && ParseInt(record.SourceRegister1)
+                && ParseInt(record.SourceRegister2);
+        }
+
+        bool ParseHex(uint64_t &value)
+        {
+            SkipWhitespace();
+            if (parseEnd - cursor > 2 && cursor[0] == '0' && (cursor[1] == 'x' || cursor[1] == 'X'))
+            {
+                cursor += 2;
+            }
+            const char *start = cursor;
+            value = 0;
+            while (cursor != parseEnd)
+            {
+                // Maps '0'-'9', 'a'-'f' and 'A'-'F' to 0-15 without a lookup per case.
+                unsigned digit = (unsigned char)*cursor - '0';
+                unsigned letter = ((unsigned char)*cursor | 0x20) - 'a';
+                if (digit > 9 && letter > 5)
+                {
+                    break;
+                }
+                value = (value << 4) | (digit <= 9 ? digit : letter + 10);
+                cursor++;
+            }
+            return cursor != start;
+        }
+
+        bool ParseInt(int &value)
+        {
+            SkipWhitespace();
+            bool negative = cursor != parseEnd && *cursor == '-';
+            cursor += negative;
+            const char *start = cursor;
+            int magnitude = 0;
+            unsigned digit;
+            while (cursor != parseEnd && (digit = (unsigned char)*cursor - '0') <= 9)
+            {
+                magnitude = magnitude * 10 + digit;
+                cursor++;
+            }
+            value = negative ? -magnitude : magnitude;
+            return cursor != start;
+        }
+};
+
+/// @brief Decodes a whole trace file into memory.
+/// @param fileName Path to the trace file.
+/// @param records [out] The decoded records, in program order.
+/// @return `true` if the file was opened and decoded without errors.
+inline bool ReadWholeTrace(const char *fileName, vector<TraceRecord> &records)
+{
+    TraceReader traceReader;
+    TraceRecord record;
+    if (!traceReader.Open(fileName))
+    {
+        return false;
+    }
+    records.clear();
+    while (traceReader.TryGetNext(record))
+    {
+        records.push_back(record);
+    }
+    return !traceReader.HasMalformedLine();
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef TRACE_SOURCE_H   // Include guard to prevent multiple inclusions
+#define TRACE_SOURCE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+#include "sim.h"
+
+/// Kinds of trace position; a position only applies to a source of its kind.
+enum TracePositionFormat
+{
+    TextTracePosition = 1,
+    BinaryTracePosition,
+    MemoryTracePosition
+};
+
+/// @brief Where a trace source resumes, stored in checkpoints.
+struct TracePosition
+{
+    uint64_t Format;
+    uint64_t Offset;        // Byte offset of the next record; its index for memory traces
+    uint64_t PreviousPc;    // Binary records encode their PC relative to the previous one
+};
+
+/// @class TraceSource
+/// @brief Interface that hands decoded trace records to fetch in program order.
+class TraceSource
+{
+    public:
+        virtual ~TraceSource() {}
+
+        /// @brief Gets the position of the next record.
+        /// @return `false` if the source cannot seek.
+        virtual bool TryGetPosition(TracePosition &position)
+        {
+            return false;
+        }
+
+        /// @brief Moves to a position taken from the same trace.
+        /// @return `false` if the source cannot seek there.
+        virtual bool Seek(const TracePosition &position)
+        {
+            return false;
+        }
+
+        /// @brief Attempts to get the next trace record.
+        /// @param record [out] Reference where the next record will be stored if available.
+        /// @return `true` if a record was available, `false` at the end of the trace.
+        virtual bool TryGetNext(TraceRecord &record) = 0;
+
+        /// @brief Gets whether every record of the trace has been handed out.
+        virtual bool IsExhausted() = 0;
+};
+
+/// @class MemoryTraceSource
+/// @brief Replays records that were already decoded into memory.
+/// The records are only read, so many sources can share one decoded trace.
+class MemoryTraceSource : public TraceSource
+{
+    public:
+        MemoryTraceSource(const TraceRecord *records, size_t count)
+        {
+            firstRecord = nextRecord = records;
+            lastRecord = records + count;
+        }
+
+        bool TryGetNext(TraceRecord &record) override
+        {
+            if (nextRecord == lastRecord)
+            {
+                return false;
+            }
+            record = *nextRecord++;
+            return true;
+        }
+
+        bool IsExhausted() override
+        {
+            return nextRecord == lastRecord;
+        }
+
+        bool TryGetPosition(TracePosition &position) override
+        {
+            position = {MemoryTracePosition, (uint64_t)(nextRecord - firstRecord), 0};
+            return true;
+        }
+
+        bool Seek(const TracePosition &position) override
+        {
+            if (position.Format != MemoryTracePosition || position.Offset > (uint64_t)(lastRecord - firstRecord))
+            {
+                return false;
+            }
+            nextRecord = firstRecord + position.Offset;
+            return true;
+        }
+
+    private:
+        const TraceRecord *firstRecord;
+        const TraceRecord *nextRecord;
+        const TraceRecord *lastRecord;
+};
+
+#endif
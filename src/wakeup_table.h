@@ -0,0 +1,93 @@
+#ifndef WAKEUP_TABLE_H   // Include guard to prevent multiple inclusions
+#define WAKEUP_TABLE_H
+
+#include <vector>
+#include "sim.h"
+#include "instruction.h"
+#include "scoreboard.h"
+
+using namespace std;
+
+/// @class WakeupTable
+/// @brief Tracks producer to consumer dependencies by ROB value.
+/// Rename records each consumer against the ROB value of its producer, and
+/// a completing producer only sets the ready bits of its own dependents.
+/// The ready bits are kept per consumer ROB value, so they are valid
+/// wherever the consumer sits (RR, DI or the IQ). Both the completed
+/// producers and the ready operands are scoreboard bits.
+class WakeupTable
+{
+    public:
+        WakeupTable(unsigned long robSize) : dependents(robSize),
+                                             completed(robSize),
+                                             sourceReady(robSize * 2)
+        {
+        }
+
+        /// @brief Resets the entry of a newly allocated ROB value.
+        /// @param robValue Rob value of the renamed instruction.
+        void AllocateEntry(int robValue)
+        {
+            completed.Clear(robValue);
+            dependents[robValue].clear();
+            sourceReady.Set(robValue * 2);
+            sourceReady.Set(robValue * 2 + 1);
+        }
+
+        /// @brief Records a renamed source operand of the consumer.
+        /// @param robValue Rob value of the consumer.
+        /// @param operand Index of the source operand (0 or 1).
+        /// @param sourceRegister Renamed source register.
+        void AddSourceOperand(int robValue, int operand, const Register &sourceRegister)
+        {
+            if (!sourceRegister.HasRobValue || completed.Test(sourceRegister.Value))
+            {
+                sourceReady.Set(robValue * 2 + operand);
+                return;
+            }
+            sourceReady.Clear(robValue * 2 + operand);
+            dependents[sourceRegister.Value].push_back({robValue, operand});
+        }
+
+        /// @brief Wakes up the dependents of a producer finishing execution.
+        /// @param robValue Rob value of the producer.
+        /// @param onInstructionReady Called with the rob value of every dependent
+        /// whose source operands all became ready.
+        template <typename Callback>
+        void Wakeup(int robValue, Callback onInstructionReady)
+        {
+            completed.Set(robValue);
+            for (auto &dependent : dependents[robValue])
+            {
+                sourceReady.Set(dependent.RobValue * 2 + dependent.Operand);
+                if (IsInstructionReady(dependent.RobValue))
+                {
+                    onInstructionReady(dependent.RobValue);
+                }
+            }
+            dependents[robValue].clear();
+        }
+
+        /// @brief Gets whether both source operands of the consumer are ready.
+        /// @param robValue Rob value of the consumer.
+        bool IsInstructionReady(int robValue)
+        {
+            return sourceReady.Test(robValue * 2) && sourceReady.Test(robValue * 2 + 1);
+        }
+
+        /// @brief Saves or restores the state through a checkpoint archive.
+        template <typename Archive>
+        void Transfer(Archive &archive)
+        {
+            archive.Vector(dependents);
+            completed.Transfer(archive);
+            sourceReady.Transfer(archive);
+        }
+
+    private:
+        vector<vector<WakeupDependent>> dependents;
+        Scoreboard completed;
+        Scoreboard sourceReady;
+};
+
+#endif
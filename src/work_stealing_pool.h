@@ -0,0 +1,104 @@
+#ifndef WORK_STEALING_POOL_H   // Include guard to prevent multiple inclusions
+#define WORK_STEALING_POOL_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/// @class WorkStealingPool
+/// @brief Runs independent jobs on a fixed number of worker threads.
+/// Jobs are dealt round-robin into one deque per worker. A worker takes jobs
+/// from the front of its own deque and, once that is empty, steals from the
+/// back of the other deques, so jobs handed in first also start first.
+class WorkStealingPool
+{
+    public:
+        WorkStealingPool(unsigned threadCount)
+        {
+            workerCount = threadCount == 0 ? 1 : threadCount;
+        }
+
+        /// @brief Gets the number of threads to use when none is requested.
+        static unsigned GetDefaultThreadCount()
+        {
+            unsigned hardwareThreads = thread::hardware_concurrency();
+            return hardwareThreads == 0 ? 1 : hardwareThreads;
+        }
+
+        /// @brief Runs every job and waits for all of them to finish.
+        /// @param jobs Job indices, in the order they should preferably start.
+        /// @param work Called once per job index, possibly from several threads at once.
+        void Run(const vector<size_t> &jobs, const function<void(size_t)> &work)
+        {
+            unsigned threadCount = workerCount < jobs.size() ? workerCount : (unsigned)jobs.size();
+            if (threadCount == 0)
+            {
+                return;
+            }
+            vector<WorkerQueue> queues(threadCount);
+            for (size_t i = 0; i < jobs.size(); i++)
+            {
+                queues[i % threadCount].Jobs.push_back(jobs[i]);
+            }
+
+            vector<thread> workers;
+            for (unsigned worker = 1; worker < threadCount; worker++)
+            {
+                workers.emplace_back([&queues, &work, worker]() { RunWorker(queues, work, worker); });
+            }
+            RunWorker(queues, work, 0);
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+    private:
+        struct WorkerQueue
+        {
+            mutex Lock;
+            deque<size_t> Jobs;
+        };
+
+        unsigned workerCount;
+
+        static void RunWorker(vector<WorkerQueue> &queues, const function<void(size_t)> &work, unsigned self)
+        {
+            size_t job;
+            while (TryTakeJob(queues, self, job))
+            {
+                work(job);
+            }
+        }
+
+        static bool TryTakeJob(vector<WorkerQueue> &queues, unsigned self, size_t &job)
+        {
+            {
+                lock_guard<mutex> guard(queues[self].Lock);
+                if (!queues[self].Jobs.empty())
+                {
+                    job = queues[self].Jobs.front();
+                    queues[self].Jobs.pop_front();
+                    return true;
+                }
+            }
+            for (size_t offset = 1; offset < queues.size(); offset++)
+            {
+                WorkerQueue &victim = queues[(self + offset) % queues.size()];
+                lock_guard<mutex> guard(victim.Lock);
+                if (!victim.Jobs.empty())
+                {
+                    job = victim.Jobs.back();
+                    victim.Jobs.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <map>
+#include "sim.h"
+#include "src/instruction.h"
+#include "src/timing_writer.h"
+#include "src/timing_log.h"
+#include "src/pipeline_view_writer.h"
+
+using namespace std;
+
+// Cycles spent per instruction, counted by value so percentiles are exact.
+class LatencyHistogram
+{
+    public:
+        void Add(int64_t cycles)
+        {
+            counts[cycles]++;
+            count++;
+            sum += cycles;
+        }
+
+        void Print(const char *name)
+        {
+            if (count == 0)
+            {
+                printf("%s,0,0.00,0,0,0,0,0\n", name);
+                return;
+            }
+            printf("%s,%" PRIu64 ",%.2f,%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 "\n",
+                name, count, (double)sum / count, counts.begin()->first,
+                GetPercentile(50), GetPercentile(90), GetPercentile(99), counts.rbegin()->first);
+        }
+
+    private:
+        map<int64_t, uint64_t> counts;
+        uint64_t count = 0;
+        int64_t sum = 0;
+
+        // Smallest value at or above the given share of the instructions.
+        int64_t GetPercentile(int percent)
+        {
+            uint64_t rank = (count * percent + 99) / 100;
+            uint64_t seen = 0;
+            for (auto &valueCount : counts)
+            {
+                seen += valueCount.second;
+                if (seen >= rank)
+                {
+                    return valueCount.first;
+                }
+            }
+            return counts.rbegin()->first;
+        }
+};
+
+void OpenLog(TimingLogReader &reader, const char *fileName)
+{
+    if (!reader.Open(fileName))
+    {
+        printf("Error: %s is not a timing log written by sim --timing-log\n", fileName);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void CheckLogEnd(TimingLogReader &reader, const char *fileName)
+{
+    if (reader.IsCorrupt())
+    {
+        fflush(stdout);
+        fprintf(stderr, "Error: Truncated or corrupt block in %s\n", fileName);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Prints the timing lines sim would have printed for the logged instructions.
+void PrintTimingLines(const char *fileName)
+{
+    TimingLogReader reader;
+    TimingLogBlock block;
+    Instruction instruction;
+    TimingWriter timingWriter = TimingWriter(stdout);
+
+    OpenLog(reader, fileName);
+    while (reader.ReadBlock(block))
+    {
+        for (uint32_t record = 0; record < block.RecordCount; record++)
+        {
+            block.GetInstruction(record, instruction);
+            timingWriter.OnRetire(instruction);
+        }
+    }
+    timingWriter.Flush();
+    CheckLogEnd(reader, fileName);
+}
+
+// Adds the cycles each instruction spent per stage and from fetch to the
+// end of retire. Only the duration columns and two begin columns are decoded.
+void AddStageLatencies(const char *fileName, LatencyHistogram *stageHistograms, LatencyHistogram &totalHistogram)
+{
+    TimingLogReader reader;
+    TimingLogBlock block;
+    uint32_t columnMask = (1u << (LogBeginCycle + PipelineRegister::FE)) | (1u << (LogBeginCycle + PipelineRegister::RT));
+    for (int stage = 0; stage < TotalPipelineRegisters; stage++)
+    {
+        columnMask |= 1u << (LogDuration + stage);
+    }
+
+    OpenLog(reader, fileName);
+    while (reader.ReadBlock(block, columnMask))
+    {
+        for (int stage = 0; stage < TotalPipelineRegisters; stage++)
+        {
+            for (int64_t duration : block.Columns[LogDuration + stage])
+            {
+                stageHistograms[stage].Add(duration);
+            }
+        }
+        for (uint32_t record = 0; record < block.RecordCount; record++)
+        {
+            totalHistogram.Add(block.Columns[LogBeginCycle + PipelineRegister::RT][record]
+                + block.Columns[LogDuration + PipelineRegister::RT][record]
+                - block.Columns[LogBeginCycle + PipelineRegister::FE][record]);
+        }
+    }
+    CheckLogEnd(reader, fileName);
+}
+
+// Reads timing logs written by sim --timing-log. "text" turns them back into
+// sim's timing lines; "stats" prints the latency distribution of each stage
+// as CSV. Logs of a checkpointed run and its resumed run can be given in order.
+int main (int argc, char* argv[])
+{
+    if (argc < 3 || (strcmp(argv[1], "text") != 0 && strcmp(argv[1], "stats") != 0))
+    {
+        printf("Usage: %s <text | stats> <timing log> [timing log ...]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (strcmp(argv[1], "text") == 0)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            PrintTimingLines(argv[i]);
+        }
+        return 0;
+    }
+
+    LatencyHistogram stageHistograms[TotalPipelineRegisters];
+    LatencyHistogram totalHistogram;
+    for (int i = 2; i < argc; i++)
+    {
+        AddStageLatencies(argv[i], stageHistograms, totalHistogram);
+    }
+    printf("stage,count,mean,min,p50,p90,p99,max\n");
+    for (int stage = 0; stage < TotalPipelineRegisters; stage++)
+    {
+        stageHistograms[stage].Print(PipelineRegisterNames[stage]);
+    }
+    totalHistogram.Print("FE-RT");
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "sim.h"
+#include "src/trace_reader.h"
+#include "src/binary_trace.h"
+
+// Converts a text trace into the compact binary trace format understood by
+// sim. Binary input is accepted too, so the tool can also re-encode traces.
+int main (int argc, char* argv[])
+{
+    TraceReader traceReader;
+    BinaryTraceWriter traceWriter;
+    TraceRecord record;
+
+    if (argc != 3)
+    {
+        printf("Usage: %s <input tracefile> <output binary tracefile>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (!traceReader.Open(argv[1]))
+    {
+        printf("Error: Unable to open file %s\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+    if (!traceWriter.Open(argv[2]))
+    {
+        printf("Error: Unable to create file %s\n", argv[2]);
+        exit(EXIT_FAILURE);
+    }
+
+    while (traceReader.TryGetNext(record))
+    {
+        if (!traceWriter.Write(record))
+        {
+            printf("Error: Op type %d of instruction %" PRIu64 " cannot be encoded\n",
+                record.OpType, traceWriter.GetRecordCount());
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (traceReader.HasMalformedLine())
+    {
+        printf("Error: Malformed line after instruction %" PRIu64 " in %s\n",
+            traceWriter.GetRecordCount(), argv[1]);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t recordCount = traceWriter.GetRecordCount();
+    if (!traceWriter.Close())
+    {
+        printf("Error: Unable to write file %s\n", argv[2]);
+        exit(EXIT_FAILURE);
+    }
+    printf("Converted %" PRIu64 " instructions from %s to %s\n", recordCount, argv[1], argv[2]);
+    return 0;
+}